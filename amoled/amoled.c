@@ -33,7 +33,7 @@
  */
 
 #include "amoled.h"
-#include "amoled_qspi_bus.h"
+#include "amoled_port.h"
 
 #include "py/obj.h"
 #include "py/runtime.h"
@@ -41,17 +41,12 @@
 #include "py/gc.h"
 #include "py/objstr.h"
 
-#include "esp_lcd_panel_io.h"
-#include "driver/spi_master.h"
-
-#include "esp_heap_caps.h"
 #include "mpfile/mpfile.h"
 #include "jpg/tjpgd565.h"
 #include "schrift/schrift.h"
 
 #include <string.h>
 #include <math.h>
-#include <wchar.h>
 
 #define AMOLED_DRIVER_VERSION "04.01.2026"
 
@@ -59,7 +54,6 @@
 #define ABS(N) (((N) < 0) ? (-(N)) : (N))
 #define mp_hal_delay_ms(delay) (mp_hal_delay_us(delay * 1000))
 
-#define MAX_POLY_CORNERS 32
 
 #define MAX_BUFFER  4800
 
@@ -157,10 +151,78 @@ Below are Bus transmission related functions.
 -----------------------------------------------------------------------------------------------------*/
 
 
+// Add a record to the bus trace ring, overwriting the oldest one when full
+static void trace_add(amoled_AMOLED_obj_t *self, uint8_t kind, uint8_t cmd, const void *data, int data_len, uint32_t len) {
+	amoled_trace_rec_t *rec = &self->trace_buf[self->trace_total % self->trace_size];
+
+	rec->time  = mp_hal_ticks_us();
+	rec->len   = len;
+	rec->kind  = kind;
+	rec->cmd   = cmd;
+	rec->frame = self->trace_frame;
+	memset(rec->data, 0, sizeof(rec->data));
+	if (data) {
+		memcpy(rec->data, data, MIN((size_t)data_len, sizeof(rec->data)));
+	}
+	self->trace_total++;
+}
+
+// Trace a memory write with the panel window it goes to
+static void trace_color(amoled_AMOLED_obj_t *self, uint8_t cmd, uint32_t len) {
+	const amoled_area_t *w = &self->window;
+	uint8_t win[8] = { w->SC >> 8, w->SC & 0xFF, w->EC >> 8, w->EC & 0xFF,
+					   w->SR >> 8, w->SR & 0xFF, w->ER >> 8, w->ER & 0xFF };
+
+	trace_add(self, TRACE_COLOR, cmd, win, 8, len);
+}
+
+// Mark the end of a frame (refresh or flush) in the bus trace
+static void trace_frame(amoled_AMOLED_obj_t *self) {
+	if (self->trace_buf) {
+		trace_add(self, TRACE_FRAME, 0, NULL, 0, 0);
+		self->trace_frame++;
+	}
+}
+
+static void shadow_invalidate(amoled_AMOLED_obj_t *self);
+
+// raise the first failed bus transfer since the last check, from the MicroPython task only
+// (the present worker can't raise, what it sent is checked once it is done)
+static void panel_check(amoled_AMOLED_obj_t *self) {
+	int err;
+
+	if (self->lcd_panel_p && self->lcd_panel_p->error && (err = self->lcd_panel_p->error(self->bus_obj))) {
+		mp_raise_msg_varg(&mp_type_OSError, MP_ERROR_TEXT("%d(panel transfer)"), err);
+	}
+}
+
+// wait until the present worker is done with the bus (double buffer mode)
+static void present_wait(amoled_AMOLED_obj_t *self) {
+	if (self->front_buf) {
+		amoled_present_wait(&self->present);
+		panel_check(self);
+	}
+}
+
+// wait for the frame slot and the TE edge before a refresh (MicroPython task only, the GIL is released)
+static void pace_frame(amoled_AMOLED_obj_t *self) {
+	if (self->te_sync.source || self->te_sync.frame_us) {
+		MP_THREAD_GIL_EXIT();
+		amoled_te_frame(&self->te_sync);
+		MP_THREAD_GIL_ENTER();
+	}
+}
+
 // send a buffer to the panel display memory using the panel tx_color
 static void write_color(amoled_AMOLED_obj_t *self, const void *buf, int len) {
+    present_wait(self);
+    shadow_invalidate(self);		//GRAM written outside of the frame buffer
     if (self->lcd_panel_p) {
+            if (self->trace_buf) {
+                trace_color(self, LCD_CMD_RAMWR, len);
+            }
             self->lcd_panel_p->tx_color(self->bus_obj, 0, buf, len);
+            panel_check(self);
     } else {
         mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to find the panel object."));
     }
@@ -168,13 +230,31 @@ static void write_color(amoled_AMOLED_obj_t *self, const void *buf, int len) {
 
 // send a buffer to the panel IC register using the panel tx_color
 static void write_spi(amoled_AMOLED_obj_t *self, int cmd, const void *buf, int len) {
+    present_wait(self);
+    if ((cmd == LCD_CMD_SWRESET) || (cmd == LCD_CMD_MADCTL) || (cmd == LCD_CMD_CASET) || (cmd == LCD_CMD_RASET)) {
+        self->window_valid = false;		//the panel window may not be the cached one anymore
+    }
+    if ((cmd == LCD_CMD_SWRESET) || (cmd == LCD_CMD_MADCTL)) {
+        shadow_invalidate(self);		//GRAM lost or addressed another way
+    }
     if (self->lcd_panel_p) {
+            if (self->trace_buf) {
+                trace_add(self, TRACE_PARAM, cmd, buf, len, len);
+            }
             self->lcd_panel_p->tx_param(self->bus_obj, cmd, buf, len);
+            panel_check(self);
     } else {
         mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to find the panel object."));
     }
 }
 
+// wait until the panel has sent every queued color transfer (asynchronous buses only)
+static void wait_panel(amoled_AMOLED_obj_t *self) {
+    if (self->lcd_panel_p && self->lcd_panel_p->wait) {
+        self->lcd_panel_p->wait(self->bus_obj);
+    }
+}
+
 // send a command directly from micropython to display
 static mp_obj_t amoled_AMOLED_send_cmd(size_t n_args, const mp_obj_t *args)
 {
@@ -183,6 +263,9 @@ static mp_obj_t amoled_AMOLED_send_cmd(size_t n_args, const mp_obj_t *args)
     uint8_t c_bits = mp_obj_get_int(args[2]);
     uint8_t len = mp_obj_get_int(args[3]);
 
+    present_wait(self);				//a present in flight would validate the caches again
+    self->window_valid = false;		//we can't know what the command does to the panel window
+    shadow_invalidate(self);		//nor to the panel memory
     if (len <= 0) {
         write_spi(self, cmd, NULL, 0);
     } else {
@@ -195,21 +278,88 @@ static mp_obj_t amoled_AMOLED_send_cmd(size_t n_args, const mp_obj_t *args)
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_send_cmd_obj, 4, 4, amoled_AMOLED_send_cmd);
 
 
-static void set_area(amoled_AMOLED_obj_t *self, uint16_t SC, uint16_t SR, uint16_t EC, uint16_t ER) {
-    
+// Build CASET / RASET parameters of a window, *caset / *raset are NULL when the panel already has them
+static void window_params(amoled_AMOLED_obj_t *self, uint16_t SC, uint16_t SR, uint16_t EC, uint16_t ER,
+						  uint8_t *bufx, uint8_t *bufy, const uint8_t **caset, const uint8_t **raset) {
+
 	/* As RM690B0 driver need offset (see ORIENTATIONS_GENERAL) then the memory area needs to follow offsets*/
 	SC += self->col_start;
 	SR += self->row_start;
 	EC += self->col_start;
 	ER += self->row_start;
 
-	uint8_t bufx[4] = {	(SC >> 8), (SC & 0xFF),	(EC >> 8), (EC & 0xFF)};
-	uint8_t bufy[4] = {	(SR >> 8), (SR & 0xFF), (ER >> 8), (ER & 0xFF)};
-	//uint8_t bufz[1] = { 0x00 };
-	
-	write_spi(self, LCD_CMD_CASET, bufx, 4); //Write CASET
-	write_spi(self, LCD_CMD_RASET, bufy, 4); //Write RASET
-	//write_spi(self, LCD_CMD_RAMWR, bufz, 0); //Write empty in case no write is done just after
+	bufx[0] = SC >> 8; bufx[1] = SC & 0xFF; bufx[2] = EC >> 8; bufx[3] = EC & 0xFF;
+	bufy[0] = SR >> 8; bufy[1] = SR & 0xFF; bufy[2] = ER >> 8; bufy[3] = ER & 0xFF;
+
+	bool same_cols = self->window_valid && (self->window.SC == SC) && (self->window.EC == EC);
+	bool same_rows = self->window_valid && (self->window.SR == SR) && (self->window.ER == ER);
+	*caset = same_cols ? NULL : bufx;
+	*raset = same_rows ? NULL : bufy;
+
+	self->window = (amoled_area_t) { SC, SR, EC, ER };
+}
+
+static void set_area(amoled_AMOLED_obj_t *self, uint16_t SC, uint16_t SR, uint16_t EC, uint16_t ER) {
+	uint8_t bufx[4];
+	uint8_t bufy[4];
+	const uint8_t *caset;
+	const uint8_t *raset;
+
+	window_params(self, SC, SR, EC, ER, bufx, bufy, &caset, &raset);
+	if (caset) {
+		write_spi(self, LCD_CMD_CASET, caset, 4); //Write CASET
+	}
+	if (raset) {
+		write_spi(self, LCD_CMD_RASET, raset, 4); //Write RASET
+	}
+	self->window_valid = true;
+}
+
+// Set the window (CASET / RASET only if changed) and write colors from its start (RAMWR)
+// or after the last written pixel (RAMWRC, caset and raset NULL) with the panel tx_window
+static void write_window(amoled_AMOLED_obj_t *self, const uint8_t *caset, const uint8_t *raset, int cmd, const void *buf, int len) {
+    if (self->lcd_panel_p == NULL) {
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to find the panel object."));
+    }
+    if (self->trace_buf) {
+        uint8_t flag = self->lcd_panel_p->tx_window ? TRACE_WINDOW_BIT : 0;
+        if (caset) {
+            trace_add(self, TRACE_PARAM | flag, LCD_CMD_CASET, caset, 4, 4);
+        }
+        if (raset) {
+            trace_add(self, TRACE_PARAM | flag, LCD_CMD_RASET, raset, 4, 4);
+        }
+        trace_color(self, cmd, len);
+    }
+    if (self->lcd_panel_p->tx_window) {
+        self->lcd_panel_p->tx_window(self->bus_obj, caset, raset, cmd, buf, len);
+    } else {
+        if (caset) {
+            self->lcd_panel_p->tx_param(self->bus_obj, LCD_CMD_CASET, caset, 4);
+        }
+        if (raset) {
+            self->lcd_panel_p->tx_param(self->bus_obj, LCD_CMD_RASET, raset, 4);
+        }
+        self->lcd_panel_p->tx_color(self->bus_obj, cmd, buf, len);
+    }
+}
+
+// Write colors to a new window
+static void write_area(amoled_AMOLED_obj_t *self, uint16_t SC, uint16_t SR, uint16_t EC, uint16_t ER, const void *buf, int len) {
+	uint8_t bufx[4];
+	uint8_t bufy[4];
+	const uint8_t *caset;
+	const uint8_t *raset;
+
+	window_params(self, SC, SR, EC, ER, bufx, bufy, &caset, &raset);
+	self->window_valid = false;		//until the panel got it
+	write_window(self, caset, raset, LCD_CMD_RAMWR, buf, len);
+	self->window_valid = true;
+}
+
+// Write colors following the last write in the same window
+static void write_continue(amoled_AMOLED_obj_t *self, const void *buf, int len) {
+	write_window(self, NULL, NULL, LCD_CMD_RAMWRC, buf, len);
 }
 
 
@@ -236,21 +386,32 @@ Below are initialization related functions.
 static mp_obj_t amoled_AMOLED_reset(mp_obj_t self_in) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(self_in);
 
+    present_wait(self);				//no present may run across the reset
+    self->window_valid = false;		//the panel window is back to its default
+    shadow_invalidate(self);
+#ifdef ESP_PLATFORM
     if (self->reset != MP_OBJ_NULL) {
+        wait_panel(self);			//nor a queued transfer
         mp_hal_pin_obj_t reset_pin = mp_hal_get_pin_obj(self->reset);
         mp_hal_pin_write(reset_pin, self->reset_level);
         mp_hal_delay_ms(300);    
         mp_hal_pin_write(reset_pin, !self->reset_level);
         mp_hal_delay_ms(200);    
-    } else {
-        write_spi(self, LCD_CMD_SWRESET, NULL, 0);
+        return mp_const_none;
     }
+#endif
+    write_spi(self, LCD_CMD_SWRESET, NULL, 0);
 
     return mp_const_none;
 }
 
 static MP_DEFINE_CONST_FUN_OBJ_1(amoled_AMOLED_reset_obj, amoled_AMOLED_reset);
 
+static bool align_area(amoled_AMOLED_obj_t *self, int x, int y, int w, int h, amoled_area_t *area);
+static void send_area(amoled_AMOLED_obj_t *self, const amoled_area_t *area);
+static void present_run(void *arg);
+static uint16_t colorRGB(uint8_t r, uint8_t g, uint8_t b);
+static inline size_t fb_bytes(amoled_AMOLED_obj_t *self, size_t pixels);
 
 //Init function for RM67162, RM690B0, SH8601, CO5300 and WS_206
 static mp_obj_t amoled_AMOLED_init(mp_obj_t self_in) {
@@ -339,7 +500,13 @@ static mp_obj_t amoled_AMOLED_init(mp_obj_t self_in) {
 	mp_hal_delay_ms(10);
 	
 	//Fill display with the framebuffer previously initialized
-	write_color(self, self->fram_buf, self->width * self->height * self->Bpp);
+	if (self->native || self->lut || self->band_ops) {
+		amoled_area_t area;
+		align_area(self, 0, 0, self->width, self->height, &area);
+		send_area(self, &area);
+	} else {
+		write_color(self, self->fram_buf, self->width * self->height * self->Bpp);
+	}
 	
 	//Finillay set brighness	
 	write_spi(self, LCD_CMD_WRDISBV, (uint8_t[]) {0xFF}, 1);                // WRITE BRIGHTNESS MAX VALUE 0xFF
@@ -361,6 +528,13 @@ mp_obj_t amoled_AMOLED_make_new(const mp_obj_type_t *type, size_t n_args, size_t
 		ARG_rotation,
         ARG_auto_refresh,
 		ARG_bus_methode,   //FOR DEVELOPPEMENT PURPOSE
+		ARG_stage_size,
+		ARG_tile_size,
+		ARG_native,
+		ARG_double_buffer,
+		ARG_te_pin,
+		ARG_band,
+		ARG_band_ops,
     };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_bus,              MP_ARG_OBJ | MP_ARG_REQUIRED, {.u_obj = MP_OBJ_NULL}     },
@@ -370,8 +544,15 @@ mp_obj_t amoled_AMOLED_make_new(const mp_obj_type_t *type, size_t n_args, size_t
         { MP_QSTR_color_space,      MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = COLOR_SPACE_RGB} },
         { MP_QSTR_bpp,              MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 16}              },
 		{ MP_QSTR_rotation,         MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 0}               },
-		{ MP_QSTR_auto_refresh,		MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_bool = true}           },
+		{ MP_QSTR_auto_refresh,		MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = AUTO_REFRESH_ON}  },
 		{ MP_QSTR_bus_methode,      MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 0}               }, //FOR DEVELOPPEMENT PURPOSE
+		{ MP_QSTR_stage_size,       MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = STAGE_BUF_SIZE}  },
+		{ MP_QSTR_tile_size,        MP_ARG_OBJ | MP_ARG_KW_ONLY,  {.u_obj = mp_const_none}   },
+		{ MP_QSTR_native,           MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false}          },
+		{ MP_QSTR_double_buffer,    MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false}          },
+		{ MP_QSTR_te_pin,           MP_ARG_OBJ | MP_ARG_KW_ONLY,  {.u_obj = mp_const_none}   },
+		{ MP_QSTR_band,             MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 0}               },
+		{ MP_QSTR_band_ops,         MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = BAND_OPS_SIZE}   },
     };
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all_kw_array(
@@ -385,6 +566,7 @@ mp_obj_t amoled_AMOLED_make_new(const mp_obj_type_t *type, size_t n_args, size_t
 
     // create new object
     amoled_AMOLED_obj_t *self = m_new_obj(amoled_AMOLED_obj_t);
+    memset(self, 0, sizeof(*self));		//bus helpers check trace, shadow and double buffer pointers from the first command
     self->base.type = &amoled_AMOLED_type;
 
     self->bus_obj = (mp_obj_base_t *)MP_OBJ_TO_PTR(args[ARG_bus].u_obj);
@@ -403,15 +585,50 @@ mp_obj_t amoled_AMOLED_make_new(const mp_obj_type_t *type, size_t n_args, size_t
 	self->type = args[ARG_type].u_int;
 
 	//Get other arguments
-	self->auto_refresh = args[ARG_auto_refresh].u_bool;
+	self->auto_refresh = args[ARG_auto_refresh].u_int;
+	if (self->auto_refresh > AUTO_REFRESH_DEFERRED) {
+		mp_raise_ValueError(MP_ERROR_TEXT("unsupported auto_refresh mode"));
+	}
     self->reset        = args[ARG_reset].u_obj;
     self->reset_level  = args[ARG_reset_level].u_bool;
     self->color_space  = args[ARG_color_space].u_int;
     self->bpp          = args[ARG_bpp].u_int;
+	self->lut          = NULL;
+	self->fram_bpp     = 0;
+	if ((self->color_space == COLOR_SPACE_MONOCHROME) != ((self->bpp == 1) || (self->bpp == 2) || (self->bpp == 4))) {
+		mp_raise_ValueError(MP_ERROR_TEXT("monochrome needs 1, 2 or 4 bpp"));
+	}
+	bool palette = (self->bpp == 8) || (self->color_space == COLOR_SPACE_MONOCHROME);
+	if (palette) {	//palette frame buffer, the panel itself stays at 16bpp, the palette is allocated once the arguments are checked
+		self->fram_bpp = self->bpp;
+		self->bpp = 16;
+	}
 	self->Bpp		   = (self->bpp + 6) >> 3;  // 16 : 2 / 18 : 3 / 24 : 3
+	if (self->fram_bpp == 0) {
+		self->fram_bpp = self->Bpp << 3;
+	}
 	self->rotation     = args[ARG_rotation].u_int;
 	self->madctl_val   = 0;
+	self->window_valid = false;
+	self->shadow_hash  = NULL;			//shadow GRAM diff is off until shadow() is called
+	self->shadow_band  = 0;
+	self->shadow_rows  = 0;
+	self->shadow_skipped   = 0;
+	self->shadow_requested = 0;
+	self->shadow_sent  = 0;
 	self->bus_methode  = args[ARG_bus_methode].u_int;   //FOR DEVELOPPEMENT PURPOSE
+	self->stage_size   = (args[ARG_stage_size].u_int >> 2) << 2;   //keep strips 32 bits aligned
+	self->native       = args[ARG_native].u_bool;
+	if (self->native && ((self->Bpp != 2) || palette)) {
+		mp_raise_ValueError(MP_ERROR_TEXT("native frame buffer needs 16bpp"));
+	}
+	self->band_rows    = args[ARG_band].u_int;
+	if ((self->band_rows & 1) || (self->band_rows && (palette || self->native || (self->Bpp != 2) || args[ARG_double_buffer].u_bool))) {
+		mp_raise_ValueError(MP_ERROR_TEXT("band needs an even number of rows, 16bpp and a single buffer"));
+	}
+	if ((args[ARG_band_ops].u_int < 1) || (args[ARG_band_ops].u_int > 0xFFFF)) {
+		mp_raise_ValueError(MP_ERROR_TEXT("band_ops must be from 1 to 65535"));
+	}
 	
 	// set RGB or BGR
     switch (self->color_space) {
@@ -423,6 +640,10 @@ mp_obj_t amoled_AMOLED_make_new(const mp_obj_type_t *type, size_t n_args, size_t
             self->madctl_val |= MADCTL_BGR_BIT; //Set Color bit to 1
         break;
 
+        case COLOR_SPACE_MONOCHROME:	//gray levels are the same in RGB and BGR
+            self->madctl_val &= ~MADCTL_BGR_BIT;
+        break;
+
         default:
             mp_raise_ValueError(MP_ERROR_TEXT("unsupported color space"));
         break;
@@ -485,18 +706,146 @@ mp_obj_t amoled_AMOLED_make_new(const mp_obj_type_t *type, size_t n_args, size_t
         break;
 	}
 
+	//Each staging buffer must hold at least 2 lines of the widest rotation
+	uint16_t max_width = 0;
+	for (uint8_t i = 0; i < 4; i++) {
+		max_width = MAX(max_width, self->rotations[i].width);
+	}
+	if (self->stage_size < self->band_rows * max_width * self->Bpp) {	//band mode : strips of band rows are built in the staging buffers
+		self->stage_size = self->band_rows * max_width * self->Bpp;
+	}
+	if (self->stage_size < 2 * max_width * self->Bpp) {
+		mp_raise_ValueError(MP_ERROR_TEXT("stage_size too small"));
+	}
+
+	//Optional dirty bitmap for deferred mode, tile_size=(w, h) with even sizes to keep areas aligned
+	mp_int_t tw = 0;
+	mp_int_t th = 0;
+	if (args[ARG_tile_size].u_obj != mp_const_none) {
+		mp_obj_t *tile_size;
+		mp_obj_get_array_fixed_n(args[ARG_tile_size].u_obj, 2, &tile_size);
+		tw = mp_obj_get_int(tile_size[0]);
+		th = mp_obj_get_int(tile_size[1]);
+		if ((tw < 2) || (th < 2) || (tw > 128) || (th > 128) || (tw & 1) || (th & 1)) {
+			mp_raise_ValueError(MP_ERROR_TEXT("tile sizes must be even, from 2 to 128"));
+		}
+	}
+
+	//Arguments are checked, nothing below raises a ValueError once buffers are allocated
+	if (palette) {
+		self->lut = heap_caps_malloc(256 * sizeof(uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);	//read for every pixel sent
+		if (self->lut == NULL) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to allocate palette."));
+		}
+		uint16_t levels = 1 << self->fram_bpp;
+		for (uint16_t i = 0; i < 256; i++) {	//default palette is RGB332, or levels of gray
+			if (levels == 256) {
+				self->lut[i] = colorRGB(((i >> 5) & 7) * 255 / 7, ((i >> 2) & 7) * 255 / 7, (i & 3) * 85);
+			} else {
+				uint8_t v = (i % levels) * 255 / (levels - 1);
+				self->lut[i] = colorRGB(v, v, v);
+			}
+		}
+	}
+
 	 //Reset the chip
 	amoled_AMOLED_reset(self);
 	
 	//Setup display rotation and get display parameters
 	set_rotation(self, self->rotation);
 	
-	//Allocate a corresponding frame buffer
-    self->fram_buf = heap_caps_aligned_calloc(RAM_ALIGNMENT, self->width * self->height, self->Bpp, MALLOC_CAP_8BIT |MALLOC_CAP_SPIRAM); 
+	//Allocate a corresponding frame buffer, or the display list of the band mode
+	self->band_ops = NULL;
+	self->band_count = 0;
+	self->band_strips = 0;
+	self->band_replayed = 0;
+	if (self->band_rows) {
+		self->band_size = args[ARG_band_ops].u_int;
+		self->band_ops = heap_caps_malloc(self->band_size * sizeof(amoled_band_op_t), MALLOC_CAP_8BIT);
+		if (self->band_ops == NULL) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to allocate display list."));
+		}
+		if (self->auto_refresh == AUTO_REFRESH_ON) {	//each drawing would replay the list
+			self->auto_refresh = AUTO_REFRESH_DEFERRED;
+		}
+	} else {
+		self->fram_buf = heap_caps_aligned_calloc(RAM_ALIGNMENT, fb_bytes(self, self->width * self->height), 1, MALLOC_CAP_8BIT |MALLOC_CAP_SPIRAM); 
 	
-    if (self->fram_buf == NULL) {
-        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to allocate Frame Buffer."));
-    }
+		if (self->fram_buf == NULL) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to allocate Frame Buffer."));
+		}
+	}
+
+	//Allocate the 2 staging buffers in internal DMA capable RAM, they are reused by every refresh
+	self->stage_idx = 0;
+	self->damage_count = 0;
+	self->damage_added = 0;
+	self->damage_flushed = 0;
+	self->damage_requested = 0;
+	self->damage_sent = 0;
+
+	//Double buffer : a second frame buffer and the worker presenting it, drawings are only sent by swap()
+	self->front_buf = NULL;
+	self->present_count = 0;
+	self->present_collect = false;
+	self->present_frames = 0;
+	self->present_blocked = 0;
+	memset(&self->present, 0, sizeof(self->present));
+	if (args[ARG_double_buffer].u_bool) {
+		self->front_buf = heap_caps_aligned_calloc(RAM_ALIGNMENT, fb_bytes(self, self->width * self->height), 1, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
+		if (self->front_buf == NULL) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to allocate front buffer."));
+		}
+		if (!amoled_present_start(&self->present, present_run, self)) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to start present task."));
+		}
+		if (self->auto_refresh == AUTO_REFRESH_ON) {
+			self->auto_refresh = AUTO_REFRESH_DEFERRED;
+		}
+	}
+
+	//TE pin : refresh(), flush() and swap() start right after a TE edge
+	memset(&self->te_sync, 0, sizeof(self->te_sync));
+	if (args[ARG_te_pin].u_obj != mp_const_none) {
+#ifdef ESP_PLATFORM
+		if (!amoled_te_pin(&self->te_sync, mp_hal_get_pin_obj(args[ARG_te_pin].u_obj))) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to install TE interrupt."));
+		}
+#else
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("TE pin not supported, use fake_te()."));
+#endif
+	}
+
+	self->trace_buf = NULL;
+	self->trace_size = 0;
+	self->trace_total = 0;
+	self->trace_frame = 0;
+
+	//Dirty bitmap, its tile sizes were checked with the other arguments
+	self->tile_w = 0;
+	self->tile_h = 0;
+	self->tile_dirty = 0;
+	self->tile_map = NULL;
+	if (tw) {
+		uint16_t max_height = 0;
+		for (uint8_t i = 0; i < 4; i++) {
+			max_height = MAX(max_height, self->rotations[i].height);
+		}
+		self->tile_w = tw;
+		self->tile_h = th;
+		self->tile_cols = (max_width + tw - 1) / tw;
+		self->tile_rows = (max_height + th - 1) / th;
+		self->tile_map = heap_caps_calloc((self->tile_cols * self->tile_rows + 7) >> 3, 1, MALLOC_CAP_8BIT);
+		if (self->tile_map == NULL) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to allocate dirty bitmap."));
+		}
+	}
+	for (uint8_t i = 0; i < 2; i++) {
+		self->stage_buf[i] = heap_caps_aligned_calloc(RAM_ALIGNMENT, 1, self->stage_size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+		if (self->stage_buf[i] == NULL) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to allocate staging buffers."));
+		}
+	}
 
 	//Finally initialize the display
 	amoled_AMOLED_init(self);
@@ -507,12 +856,35 @@ mp_obj_t amoled_AMOLED_make_new(const mp_obj_type_t *type, size_t n_args, size_t
 static mp_obj_t amoled_AMOLED_deinit(mp_obj_t self_in) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(self_in);
 
+    amoled_te_stop(&self->te_sync);
+	heap_caps_free((void*)self->shadow_hash);
+	self->shadow_hash = NULL;
+
+    if (self->front_buf) {
+        amoled_present_stop(&self->present);
+        heap_caps_free((void*)self->front_buf);
+        self->front_buf = NULL;
+    }
+
     if (self->lcd_panel_p) {
         self->lcd_panel_p->deinit(self->bus_obj);
     }
 
     heap_caps_free((void*)self->fram_buf);
 	self->fram_buf = NULL;
+	heap_caps_free((void*)self->band_ops);
+	self->band_ops = NULL;
+	heap_caps_free((void*)self->lut);
+	self->lut = NULL;
+
+	for (uint8_t i = 0; i < 2; i++) {
+		heap_caps_free((void*)self->stage_buf[i]);
+		self->stage_buf[i] = NULL;
+	}
+	heap_caps_free((void*)self->tile_map);
+	self->tile_map = NULL;
+	heap_caps_free((void*)self->trace_buf);
+	self->trace_buf = NULL;
 
     //m_del_obj(amoled_AMOLED_obj_t, self); 
     return mp_const_none;
@@ -583,6 +955,77 @@ Below are buffers and screen buffers related function.
 ------------------------------------------------------------------------------------------------------*/
 
 
+//Band mode : record a fill in the display list, clipped to the display.
+//A fill of the whole display hides everything drawn before, so the list starts again from it.
+static void band_add(amoled_AMOLED_obj_t *self, int x, int y, int w, int h, uint16_t color) {
+	if (x < 0) { w += x; x = 0; }
+	if (y < 0) { h += y; y = 0; }
+	if (x + w > self->width)  w = self->width - x;
+	if (y + h > self->height) h = self->height - y;
+	if ((w < 1) || (h < 1)) {
+		return;
+	}
+
+	if ((w == self->width) && (h == self->height)) {
+		self->band_count = 0;
+	}
+	if (self->band_count) {		//pixels drawn one after the other on a line (text, lines) make one fill
+		amoled_band_op_t *last = &self->band_ops[self->band_count - 1];
+		if ((h == 1) && (last->h == 1) && (last->y == y) && (last->color == color) && (last->x + last->w == x)) {
+			last->w += w;
+			return;
+		}
+	}
+	if (self->band_count >= self->band_size) {
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Display list full, fill() the display to start a new one."));
+	}
+	self->band_ops[self->band_count++] = (amoled_band_op_t) { x, y, w, h, color };
+}
+
+//API colors are byte swapped RGB565 (see BLACK..WHITE), convert one to the frame buffer format (and back)
+//With a palette, API colors are the palette indices (WHITE is the last gray level in monochrome)
+static inline uint16_t fb_color(amoled_AMOLED_obj_t *self, uint16_t color) {
+	if (self->lut) {
+		return color & ((1 << self->fram_bpp) - 1);
+	}
+	return self->native ? AMOLED_SWAP16(color) : color;
+}
+
+//Store a frame buffer color (from fb_color) at pixel index idx.
+//1, 2 and 4 bpp pixels are packed in a bit stream, the first pixel in the high bits of a byte.
+static inline void fb_put(amoled_AMOLED_obj_t *self, size_t idx, uint16_t color) {
+	if (self->band_ops) {
+		band_add(self, idx % self->width, idx / self->width, 1, 1, color);
+	} else if (self->fram_bpp == 16) {
+		self->fram_buf[idx] = color;
+	} else if (self->fram_bpp == 8) {
+		((uint8_t *)self->fram_buf)[idx] = color;
+	} else {
+		size_t bit = idx * self->fram_bpp;
+		uint8_t shift = 8 - self->fram_bpp - (bit & 7);
+		uint8_t mask = ((1 << self->fram_bpp) - 1) << shift;
+		uint8_t *p = (uint8_t *)self->fram_buf + (bit >> 3);
+		*p = (*p & ~mask) | ((color << shift) & mask);
+	}
+}
+
+//Frame buffer pixels from index idx for the pixel kernels, NULL when they are not plain 16 bits pixels
+//(band mode, palette) and fb_put must be used
+static inline uint16_t *fb_row16(amoled_AMOLED_obj_t *self, size_t idx) {
+	return ((self->fram_bpp == 16) && !self->band_ops) ? &self->fram_buf[idx] : NULL;
+}
+
+//Size in bytes of a number of frame buffer pixels
+static inline size_t fb_bytes(amoled_AMOLED_obj_t *self, size_t pixels) {
+	return (pixels * self->fram_bpp + 7) >> 3;
+}
+
+//Bytes holding n frame buffer pixels from pixel index idx, offset gets the first one
+static inline size_t fb_span(amoled_AMOLED_obj_t *self, size_t idx, size_t n, size_t *offset) {
+	*offset = (idx * self->fram_bpp) >> 3;
+	return fb_bytes(self, idx + n) - *offset;
+}
+
 //Return color from R,G,B values
 static uint16_t colorRGB(uint8_t r, uint8_t g, uint8_t b) {
     uint16_t c = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | ((b & 0xF8) >> 3);
@@ -590,6 +1033,14 @@ static uint16_t colorRGB(uint8_t r, uint8_t g, uint8_t b) {
 }
 
 static mp_obj_t amoled_AMOLED_colorRGB(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (self->lut && (self->fram_bpp < 8)) {	//gray level of the default palette
+        uint16_t y = (mp_obj_get_int(args[1]) * 77 + mp_obj_get_int(args[2]) * 150 + mp_obj_get_int(args[3]) * 29) >> 8;
+        return MP_OBJ_NEW_SMALL_INT(y >> (8 - self->fram_bpp));
+    }
+    if (self->lut) {	//index of the default RGB332 palette
+        return MP_OBJ_NEW_SMALL_INT((mp_obj_get_int(args[1]) & 0xE0) | ((mp_obj_get_int(args[2]) & 0xE0) >> 3) | ((mp_obj_get_int(args[3]) & 0xC0) >> 6));
+    }
     return MP_OBJ_NEW_SMALL_INT(colorRGB(
         (uint8_t)mp_obj_get_int(args[1]),
         (uint8_t)mp_obj_get_int(args[2]),
@@ -599,193 +1050,859 @@ static mp_obj_t amoled_AMOLED_colorRGB(size_t n_args, const mp_obj_t *args) {
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_colorRGB_obj, 4, 4, amoled_AMOLED_colorRGB);
 
 
-//This function send a part of the frame_buffer to the display memory
-static void refresh_display(amoled_AMOLED_obj_t *self, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+// Align an area on the panel constraints and clip it to the display, return false if nothing is left
+static bool align_area(amoled_AMOLED_obj_t *self, int x, int y, int w, int h, amoled_area_t *area) {
 
-	if (self->auto_refresh) {
-		
-		uint8_t  BPP=self->Bpp;
-		uint16_t WIDTH=self->width;
-		
-		// The SC[15:0] and SR[15:0] must be divisible by 2 (SC or SR Even)
-		uint16_t SC = (x >> 1) << 1;
-		uint16_t SR = (y >> 1) << 1;
+	//Callers often give xmax-xmin as width, a null size still means one line or one column
+	if (w < 1) w = 1;
+	if (h < 1) h = 1;
+	if (x < 0) { w += x; x = 0; }
+	if (y < 0) { h += y; y = 0; }
+	if ((w < 1) || (h < 1) || (x >= self->width) || (y >= self->height)) {
+		return false;
+	}
+	if (x + w > self->width)  w = self->width - x;
+	if (y + h > self->height) h = self->height - y;
 
-		//EC[15:0]-SC[15:0]+1 must be divisible by 2 (so EC must be Odd)
-		uint16_t EC = (((x+w-1) >> 1) << 1 ) + 1;
-		uint16_t ER = (((y+h-1) >> 1) << 1 ) + 1;
+	// The SC[15:0] and SR[15:0] must be divisible by 2 (SC or SR Even)
+	area->SC = (x >> 1) << 1;
+	area->SR = (y >> 1) << 1;
 
-		//calculate real width
-		uint16_t w1 = EC - SC + 1;
-		uint16_t h1 = ER - SR + 1;
-		
-		uint32_t temp_buf_size = 0;
-		uint32_t temp_buf_write_size = 0;
-		
-		if(self->bus_methode == 0) {
-			
-			//Simpliest version direct writing (write to display every 2 lines)
-			
-			temp_buf_size = 2 * w1;            //2 lines of given width
-			uint16_t temp_buf[temp_buf_size];  //Allocate an array
-			size_t  fram_buf_idx = 0;
-			size_t  temp_buf_idx = 0;
-			temp_buf_write_size = temp_buf_size*BPP;
-			bool b = false;
-			
-			
-			for(uint16_t line = SR; line <= ER; line++) {
-				fram_buf_idx = line * WIDTH + SC;
-				for(uint16_t col = SC; col <= EC; col++) {
-					temp_buf[temp_buf_idx]=self->fram_buf[fram_buf_idx];
-					fram_buf_idx++;
-					temp_buf_idx++;
-				}
-				if (b) { //One every two line we write to the display
-					set_area(self, SC, line-1, EC, line);
-					write_color(self, temp_buf, temp_buf_write_size);
-					temp_buf_idx = 0;
-					b = false;
+	//EC[15:0]-SC[15:0]+1 must be divisible by 2 (so EC must be Odd)
+	area->EC = (((x+w-1) >> 1) << 1 ) + 1;
+	area->ER = (((y+h-1) >> 1) << 1 ) + 1;
+	return true;
+}
+
+static uint32_t area_size(const amoled_area_t *area) {
+	return (uint32_t)(area->EC - area->SC + 1) * (area->ER - area->SR + 1);
+}
+
+//This function send an aligned part of a frame buffer (fram_buf or front_buf) to the display memory
+static void send_fb_window(amoled_AMOLED_obj_t *self, const uint16_t *fb, const amoled_area_t *area) {
+
+	uint8_t  BPP=self->Bpp;
+	uint16_t WIDTH=self->width;
+	uint16_t SC = area->SC;
+	uint16_t EC = area->EC;
+	uint16_t ER = area->ER;
+
+	//calculate real width
+	uint16_t w1 = EC - SC + 1;
+
+	uint32_t line_size = w1 * BPP;
+	uint16_t strip_lines = ((self->stage_size / line_size) >> 1) << 1;	//even number of lines, at least 2 (checked at init)
+	bool     full_width = (SC == 0) && (EC == WIDTH - 1);	//rows are contiguous in fram_buf
+
+	//Copy the area strip by strip into the staging buffers, alternating between the two of them.
+	//Writing a strip waits for the bus, so the strip being filled is never the one in flight and on an
+	//asynchronous bus the copy of a strip overlaps the transmission of the previous one.
+	//The window is set once for the whole area, next strips follow the first one with RAMWRC.
+	for (uint16_t line = area->SR; line <= ER; line += strip_lines) {
+		uint16_t last = min_val(line + strip_lines - 1, ER);
+		uint8_t  *strip = (uint8_t *)self->stage_buf[self->stage_idx];
+
+		if (self->native) {		//swap to the panel byte order while copying
+			for (uint16_t l = line; l <= last; l++) {
+				amoled_copy_swap16((uint16_t *)strip, &fb[l * WIDTH + SC], w1);
+				strip += line_size;
+			}
+		} else if (self->lut) {	//expand the palette indices to panel colors
+			for (uint16_t l = line; l <= last; l++) {
+				if (self->fram_bpp == 8) {
+					amoled_expand8((uint16_t *)strip, (const uint8_t *)fb + l * WIDTH + SC, self->lut, w1);
 				} else {
-					b = true;
+					amoled_expand_bits((uint16_t *)strip, (const uint8_t *)fb, (l * WIDTH + SC) * self->fram_bpp, self->fram_bpp, self->lut, w1);
 				}
+				strip += line_size;
+			}
+		} else if (full_width) {
+			amoled_copy16((uint16_t *)strip, &fb[line * WIDTH], (last - line + 1) * line_size / 2);
+		} else {
+			for (uint16_t l = line; l <= last; l++) {
+				amoled_copy16((uint16_t *)strip, &fb[l * WIDTH + SC], line_size / 2);
+				strip += line_size;
 			}
 		}
-		
-		if(self->bus_methode == 1) {
-		
-			//Original code leading to artefact, I believe they where due to the allocation
-			//of buffer in SPIRAM that was conflicting with SPI transmission. The code was damn fast
-			//but artefacts where unacceptables... 
-			//Line with MALLOC_CAP_DMA doesn't change but crashes with too big buffer (lack of memoy)
-			//Alignment doesn't seem to change anything (maybe faster...writing but still artefacts)
-			
-			temp_buf_size = w1 * h1;   // full buffered
-			self->temp_buf = heap_caps_aligned_calloc(RAM_ALIGNMENT, temp_buf_size, BPP, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
-			
-			//Copy frame_buffer to partial_frame_buffer
-			size_t  fram_buf_idx = 0;
-			size_t  temp_buf_idx = 0;
-			
-			temp_buf_write_size = w1*BPP;
+		if (line == area->SR) {
+			write_area(self, SC, area->SR, EC, ER, self->stage_buf[self->stage_idx], (last - line + 1) * line_size);
+		} else {
+			write_continue(self, self->stage_buf[self->stage_idx], (last - line + 1) * line_size);
+		}
+		self->stage_idx ^= 1;
+	}
+}
 
-			for (uint16_t line = SR; line <= ER; line++) {
-				fram_buf_idx = line * WIDTH + SC;
-				memcpy(&self->temp_buf[temp_buf_idx], &self->fram_buf[fram_buf_idx], temp_buf_write_size);
-				temp_buf_idx += w1;
-			}
-			
-			//Set display areas and write the partial frame buffer
-			set_area(self, SC, SR, EC, ER);
-			write_color(self, self->temp_buf, temp_buf_size * BPP);
+// Hash of one shadow cell (2 rows from x0 to x1 included), never 0 so 0 can mean unknown
+static uint32_t shadow_cell_hash(amoled_AMOLED_obj_t *self, const uint16_t *fb, uint16_t row, uint16_t x0, uint16_t x1) {
+	uint32_t h = 0x811C9DC5;
+	for (uint16_t r = row; r <= row + 1; r++) {
+		size_t offset;
+		size_t n = fb_span(self, r * self->width + x0, x1 - x0 + 1, &offset);	//packed pixels : bytes shared with a neighbour are hashed too
+		const uint8_t *p = (const uint8_t *)fb + offset;
+		for (; n >= 4; n -= 4) {
+			uint32_t w;
+			memcpy(&w, p, sizeof(w));
+			h = (h ^ w) * 0x01000193;
+			h ^= h >> 15;
+			p += 4;
+		}
+		while (n--) {
+			h = (h ^ *p++) * 0x01000193;
+		}
+	}
+	return h ? h : 1;
+}
+
+// Forget what the panel holds, the next refreshes are sent in full
+static void shadow_invalidate(amoled_AMOLED_obj_t *self) {
+	if (self->shadow_hash) {
+		memset(self->shadow_hash, 0, self->shadow_cols * self->shadow_pairs * sizeof(uint32_t));
+	}
+}
+
+//Send an aligned area, or with the shadow GRAM only the cells that changed since they were last sent.
+//Row pairs with changes are gathered in runs, each run is sent as one window spanning its changed cells.
+static void send_fb_area(amoled_AMOLED_obj_t *self, const uint16_t *fb, const amoled_area_t *area) {
+	if (self->shadow_hash == NULL) {
+		send_fb_window(self, fb, area);
+		return;
+	}
 
-			//Than partial frame buffer  memory and return
-			heap_caps_free(self->temp_buf);
+	uint16_t band = self->shadow_band;
+	uint16_t first_cell = area->SC / band;
+	uint16_t last_cell = area->EC / band;
+	amoled_area_t run;
+	bool in_run = false;
+
+	self->shadow_requested += area_size(area) * self->Bpp;
+	for (uint16_t row = area->SR; row <= area->ER; row += 2) {
+		uint32_t *hash = &self->shadow_hash[(row >> 1) * self->shadow_cols];
+		int first = -1;
+		int last = -1;
+
+		for (uint16_t c = first_cell; c <= last_cell; c++) {
+			uint32_t h = shadow_cell_hash(self, fb, row, c * band, min_val((c + 1) * band, self->width) - 1);
+			if (h != hash[c]) {
+				hash[c] = h;
+				if (first < 0) first = c;
+				last = c;
+			}
 		}
-		
-		if(self->bus_methode == 2) {
-		
-			//Hybrid method, copy to temp_fb without memcpy and write the full buffer to display
-			
-			temp_buf_size = w1 * h1;   // full buffered
-			self->temp_buf = heap_caps_aligned_calloc(RAM_ALIGNMENT, temp_buf_size, BPP, MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
-			
-			//Copy frame_buffer to partial_frame_buffer
-			size_t  fram_buf_idx = 0;
-			size_t  temp_buf_idx = 0;
-			
-			for(uint16_t line = SR; line <= ER; line++) {
-				fram_buf_idx = line * WIDTH + SC;
-				for(uint16_t col = SC; col <= EC; col++) {
-					self->temp_buf[temp_buf_idx]=self->fram_buf[fram_buf_idx];
-					fram_buf_idx++;
-					temp_buf_idx++;
-				}
+		self->shadow_rows += 2;
+
+		if (first >= 0) {
+			uint16_t SC = first * band;
+			uint16_t EC = min_val((last + 1) * band, self->width) - 1;
+			if (in_run) {
+				run.SC = MIN(run.SC, SC);
+				run.EC = MAX(run.EC, EC);
+				run.ER = row + 1;
+			} else {
+				run = (amoled_area_t) { SC, row, EC, row + 1 };
+				in_run = true;
 			}
-			
-			//Set display areas and write the partial frame buffer
-			set_area(self, SC, SR, EC, ER);
-			write_color(self, self->temp_buf, temp_buf_size * BPP);
-
-			//Than partial frame buffer  memory and return
-			heap_caps_free(self->temp_buf);
+		} else {
+			self->shadow_skipped += 2;
+		}
+		if (in_run && ((first < 0) || (row + 1 >= area->ER))) {
+			send_fb_window(self, fb, &run);
+			self->shadow_sent += area_size(&run) * self->Bpp;
+			in_run = false;
 		}
 	}
 }
 
-//Refresh whole (if no args) or a portion of the display (need x,y,w,h)
-static mp_obj_t amoled_AMOLED_refresh(size_t n_args, const mp_obj_t *args) {
-	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-	bool save_auto_refresh = self->auto_refresh;  //Save auto_refresh value
-		
-	self->auto_refresh = true;	// Allow to write to screen buffer
-	
-	if (n_args > 4) {	//if x0..y1 exist, only update partial area
-		refresh_display(self, mp_obj_get_int(args[1]), mp_obj_get_int(args[2]), mp_obj_get_int(args[3]),  mp_obj_get_int(args[4]));
-	} else {			//otherwise update full screen
-		refresh_display(self, 0, 0, self->width, self->height);
+//Band mode : replay the display list into the staging buffers strip by strip, each fill clipped to the strip,
+//and send the strips. A strip starts black, then gets every fill recorded since the last full display fill.
+static void band_send(amoled_AMOLED_obj_t *self, const amoled_area_t *area) {
+	uint16_t w1 = area->EC - area->SC + 1;
+	uint16_t strip_lines = MIN(self->band_rows, ((self->stage_size / (w1 * self->Bpp)) >> 1) << 1);
+
+	for (uint16_t line = area->SR; line <= area->ER; line += strip_lines) {
+		uint16_t last = min_val(line + strip_lines - 1, area->ER);
+		uint16_t *strip = self->stage_buf[self->stage_idx];
+		uint32_t size = (last - line + 1) * w1 * self->Bpp;
+
+		memset(strip, 0, size);
+		for (uint16_t i = 0; i < self->band_count; i++) {
+			const amoled_band_op_t *op = &self->band_ops[i];
+			int x0 = MAX(op->x, area->SC);
+			int x1 = MIN(op->x + op->w - 1, area->EC);
+			int y0 = MAX(op->y, line);
+			int y1 = MIN(op->y + op->h - 1, last);
+			if ((x0 > x1) || (y0 > y1)) {
+				continue;
+			}
+			for (int y = y0; y <= y1; y++) {
+				amoled_fill16(&strip[(y - line) * w1 + x0 - area->SC], op->color, x1 - x0 + 1);
+			}
+			self->band_replayed++;
+		}
+		if (line == area->SR) {
+			write_area(self, area->SC, area->SR, area->EC, area->ER, strip, size);
+		} else {
+			write_continue(self, strip, size);
+		}
+		self->stage_idx ^= 1;
+		self->band_strips++;
 	}
-	self->auto_refresh = save_auto_refresh;  //Restore auto_refresh value
-	
-    return mp_const_none;
 }
 
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_refresh_obj, 1, 5, amoled_AMOLED_refresh);
+//Send an aligned part of the frame buffer being drawn
+static void send_area(amoled_AMOLED_obj_t *self, const amoled_area_t *area) {
+	present_wait(self);
+	if (self->band_ops) {
+		band_send(self, area);
+	} else {
+		send_fb_area(self, self->fram_buf, area);
+	}
+	panel_check(self);
+}
 
+// Send a flushed area, or keep it for the present worker when swap() collects the areas of a frame
+static void flush_area(amoled_AMOLED_obj_t *self, const amoled_area_t *area) {
+	if (!self->present_collect) {
+		send_area(self, area);
+	} else if (self->present_count < PRESENT_MAX_AREAS) {
+		self->present_areas[self->present_count++] = *area;
+	} else {
+		amoled_area_t *d = &self->present_areas[PRESENT_MAX_AREAS - 1];
+		d->SC = MIN(d->SC, area->SC);
+		d->SR = MIN(d->SR, area->SR);
+		d->EC = MAX(d->EC, area->EC);
+		d->ER = MAX(d->ER, area->ER);
+	}
+}
 
-// This fill the frame buffer area, it has no dimension check, all should be done previously
-static void fill_frame_buffer(amoled_AMOLED_obj_t *self, uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
-	
-	size_t fram_buf_idx;
-	
-    if (self->fram_buf == NULL) {
-        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("No framebuffer available."));
-    }
-	
-	for (uint16_t line = 0; line < h; line++) {
-		fram_buf_idx = ((y + line) * self->width) + x;
-		wmemset(&self->fram_buf[fram_buf_idx],color, w);
+#define TILE_BIT(self, col, row)	((row) * (self)->tile_cols + (col))
+#define TILE_IS_DIRTY(self, bit)	((self)->tile_map[(bit) >> 3] & (1 << ((bit) & 7)))
+
+// Mark the tiles covered by an area as dirty
+static void tile_mark(amoled_AMOLED_obj_t *self, const amoled_area_t *area) {
+	for (uint16_t row = area->SR / self->tile_h; row <= area->ER / self->tile_h; row++) {
+		for (uint16_t col = area->SC / self->tile_w; col <= area->EC / self->tile_w; col++) {
+			uint32_t bit = TILE_BIT(self, col, row);
+			if (!TILE_IS_DIRTY(self, bit)) {
+				self->tile_map[bit >> 3] |= (1 << (bit & 7));
+				self->tile_dirty++;
+			}
+		}
 	}
+}
 
-    if ((!self->hold_display) & (self->auto_refresh)) {
-		refresh_display(self,x,y,w,h);
+// Send the dirty tiles : each horizontal run of dirty tiles is extended down while the same
+// tiles are dirty on the next rows, then sent as one window and cleared
+static void tile_flush(amoled_AMOLED_obj_t *self) {
+	uint16_t cols = (self->width + self->tile_w - 1) / self->tile_w;
+	uint16_t rows = (self->height + self->tile_h - 1) / self->tile_h;
+
+	for (uint16_t row = 0; (row < rows) && self->tile_dirty; row++) {
+		uint16_t col = 0;
+		while (col < cols) {
+			if (!TILE_IS_DIRTY(self, TILE_BIT(self, col, row))) {
+				col++;
+				continue;
+			}
+			uint16_t first = col;
+			while ((col < cols) && TILE_IS_DIRTY(self, TILE_BIT(self, col, row))) {
+				col++;
+			}
+			uint16_t last_row = row;
+			bool full = true;
+			while (full && (last_row + 1 < rows)) {
+				for (uint16_t c = first; c < col; c++) {
+					if (!TILE_IS_DIRTY(self, TILE_BIT(self, c, last_row + 1))) {
+						full = false;
+						break;
+					}
+				}
+				if (full) last_row++;
+			}
+			for (uint16_t r = row; r <= last_row; r++) {
+				for (uint16_t c = first; c < col; c++) {
+					uint32_t bit = TILE_BIT(self, c, r);
+					self->tile_map[bit >> 3] &= ~(1 << (bit & 7));
+				}
+			}
+			self->tile_dirty -= (col - first) * (last_row - row + 1);
+
+			//Tile sizes are even and so are display sizes, the window stays aligned
+			amoled_area_t area = {
+				first * self->tile_w,
+				row * self->tile_h,
+				min_val(col * self->tile_w, self->width) - 1,
+				min_val((last_row + 1) * self->tile_h, self->height) - 1
+			};
+			flush_area(self, &area);
+			self->damage_flushed++;
+			self->damage_sent += area_size(&area) * self->Bpp;
+		}
 	}
 }
 
+// Add a damaged area to the pending list, merging areas when one transfer is cheaper than two
+static void damage_add(amoled_AMOLED_obj_t *self, amoled_area_t *area) {
 
-/*-----------------------------------------------------------------------------------------------------
-Below are drawing functions : Pixel, lines, rectangles, filled circles, a.s.o
-------------------------------------------------------------------------------------------------------*/
+	self->damage_added++;
+	self->damage_requested += area_size(area) * self->Bpp;
 
+	if (self->tile_map) {
+		tile_mark(self, area);
+		return;
+	}
 
-static void pixel(amoled_AMOLED_obj_t *self, uint16_t x, uint16_t y, uint16_t color) {
-	uint32_t fram_buf_idx;
-	if ((x < self->width) & (y < self->height)) {
-		fram_buf_idx = (y * self->width) + x;
-		self->fram_buf[fram_buf_idx] = color;
-		if (!self->hold_display & self->auto_refresh) {
-			refresh_display(self,x,y,1,1);
+	//Merge with an existing area while it is worth it, the merged area may now touch another one
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (uint8_t i = 0; i < self->damage_count; i++) {
+			amoled_area_t *d = &self->damage[i];
+			amoled_area_t u = {
+				MIN(d->SC, area->SC), MIN(d->SR, area->SR),
+				MAX(d->EC, area->EC), MAX(d->ER, area->ER)
+			};
+			if (area_size(&u) <= area_size(d) + area_size(area) + DAMAGE_MERGE_COST) {
+				*area = u;
+				self->damage[i] = self->damage[--self->damage_count];	//remove it, the union is added back
+				merged = true;
+				break;
+			}
+		}
+	}
+
+	//List full : merge with the area that grows the least
+	if (self->damage_count == DAMAGE_MAX_RECTS) {
+		uint8_t best = 0;
+		uint32_t best_cost = UINT32_MAX;
+		for (uint8_t i = 0; i < self->damage_count; i++) {
+			amoled_area_t *d = &self->damage[i];
+			amoled_area_t u = {
+				MIN(d->SC, area->SC), MIN(d->SR, area->SR),
+				MAX(d->EC, area->EC), MAX(d->ER, area->ER)
+			};
+			uint32_t cost = area_size(&u) - area_size(d);
+			if (cost < best_cost) {
+				best_cost = cost;
+				best = i;
+			}
 		}
+		amoled_area_t *d = &self->damage[best];
+		d->SC = MIN(d->SC, area->SC);
+		d->SR = MIN(d->SR, area->SR);
+		d->EC = MAX(d->EC, area->EC);
+		d->ER = MAX(d->ER, area->ER);
+		return;
 	}
+	self->damage[self->damage_count++] = *area;
 }
 
-static mp_obj_t amoled_AMOLED_pixel(size_t n_args, const mp_obj_t *args) {
-    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    uint16_t x = mp_obj_get_int(args[1]);
-    uint16_t y = mp_obj_get_int(args[2]);
-    uint16_t color = mp_obj_get_int(args[3]);
+// Send every pending damaged area to the display
+static void flush_damage(amoled_AMOLED_obj_t *self) {
+	if (self->tile_map) {
+		tile_flush(self);
+	}
+	for (uint8_t i = 0; i < self->damage_count; i++) {
+		flush_area(self, &self->damage[i]);
+		self->damage_flushed++;
+		self->damage_sent += area_size(&self->damage[i]) * self->Bpp;
+	}
+	self->damage_count = 0;
+}
 
-    pixel(self, x, y, color);
-    return mp_const_none;
+// Forget the pending damaged areas, the caller sends or redraws the whole frame
+static void drop_damage(amoled_AMOLED_obj_t *self) {
+	self->damage_count = 0;
+	if (self->tile_map) {
+		memset(self->tile_map, 0, (self->tile_cols * self->tile_rows + 7) >> 3);
+		self->tile_dirty = 0;
+	}
 }
 
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_pixel_obj, 4, 4, amoled_AMOLED_pixel);
+//Called by drawing functions : send the area at once or record it depending on auto_refresh
+static void refresh_display(amoled_AMOLED_obj_t *self, int x, int y, int w, int h) {
+	amoled_area_t area;
 
+	if (self->play_capture) {	//play() and batch calls refresh the union of the areas once
+		self->play_x0 = MIN(self->play_x0, x);
+		self->play_y0 = MIN(self->play_y0, y);
+		self->play_x1 = MAX(self->play_x1, x + w);
+		self->play_y1 = MAX(self->play_y1, y + h);
+		return;
+	}
 
-static mp_obj_t amoled_AMOLED_fill(size_t n_args, const mp_obj_t *args) {
-    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    uint16_t color = mp_obj_get_int(args[1]);
-	
+	if (self->auto_refresh && align_area(self, x, y, w, h, &area)) {
+		if (self->auto_refresh == AUTO_REFRESH_DEFERRED) {
+			damage_add(self, &area);
+		} else {
+			send_area(self, &area);
+		}
+	}
+}
+
+//Collect the areas refreshed from now on, refresh_release() refreshes their union once
+static void refresh_capture(amoled_AMOLED_obj_t *self) {
+	self->play_capture = true;
+	self->play_x0 = INT_MAX;
+	self->play_y0 = INT_MAX;
+	self->play_x1 = INT_MIN;
+	self->play_y1 = INT_MIN;
+}
+
+static void refresh_release(amoled_AMOLED_obj_t *self) {
+	self->play_capture = false;
+	if (self->play_x0 <= self->play_x1) {
+		refresh_display(self, self->play_x0, self->play_y0, self->play_x1 - self->play_x0, self->play_y1 - self->play_y0);
+	}
+}
+
+//Run a batch drawing between refresh_capture() and refresh_release(). When it raises, the areas already
+//drawn are refreshed and the capture is over before the exception goes on, or every later refresh is lost.
+static void refresh_batch(amoled_AMOLED_obj_t *self, void (*draw)(amoled_AMOLED_obj_t *self, const amoled_batch_t *batch), const amoled_batch_t *batch) {
+	refresh_capture(self);
+	nlr_buf_t nlr;
+	if (nlr_push(&nlr) == 0) {
+		draw(self, batch);
+		nlr_pop();
+	} else {
+		refresh_release(self);
+		nlr_jump(nlr.ret_val);
+	}
+	refresh_release(self);
+}
+
+//Run by the present worker : send the collected areas of front_buf and wait until they are on the wire,
+//so front_buf can be drawn again after the next swap()
+static void present_run(void *arg) {
+	amoled_AMOLED_obj_t *self = (amoled_AMOLED_obj_t *)arg;
+
+	if (self->te_sync.source || self->te_sync.frame_us) {
+		amoled_te_frame(&self->te_sync);
+	}
+	for (uint8_t i = 0; i < self->present_count; i++) {
+		send_fb_area(self, self->front_buf, &self->present_areas[i]);
+	}
+	wait_panel(self);
+	trace_frame(self);
+	self->present_frames++;
+}
+
+//Double buffer : present the frame drawn so far and continue drawing in the other buffer.
+//In deferred mode only the damaged areas are sent and copied into the new back buffer, which stays
+//equal to the presented frame. Otherwise the whole frame is sent and the back buffer holds the frame
+//before, unless copy is True. Returns the time in us spent waiting for the previous present.
+static mp_obj_t amoled_AMOLED_swap(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	bool copy = (n_args > 1) && mp_obj_is_true(args[1]);
+
+	if (self->front_buf == NULL) {
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Double buffer is not enabled."));
+	}
+
+	mp_uint_t start = mp_hal_ticks_us();
+	if (self->present.busy) {
+		self->present_blocked++;
+	}
+	present_wait(self);
+	mp_uint_t blocked = mp_hal_ticks_us() - start;
+
+	//Areas of the new frame
+	self->present_count = 0;
+	if ((self->auto_refresh == AUTO_REFRESH_DEFERRED) && !copy) {
+		self->present_collect = true;
+		flush_damage(self);
+		self->present_collect = false;
+	} else {
+		drop_damage(self);
+		align_area(self, 0, 0, self->width, self->height, &self->present_areas[0]);
+		self->present_count = 1;
+	}
+
+	uint16_t *front = self->fram_buf;
+	self->fram_buf = self->front_buf;
+	self->front_buf = front;
+	amoled_present_kick(&self->present);
+
+	//Bring the new back buffer up to date while the worker sends (both only read front_buf)
+	if (copy) {
+		memcpy(self->fram_buf, self->front_buf, fb_bytes(self, self->width * self->height));
+	} else if (self->auto_refresh == AUTO_REFRESH_DEFERRED) {
+		for (uint8_t i = 0; i < self->present_count; i++) {
+			const amoled_area_t *a = &self->present_areas[i];
+			for (uint16_t l = a->SR; l <= a->ER; l++) {
+				size_t offset;	//bytes shared with pixels outside the area are copied too, these pixels are the same in both buffers
+				size_t size = fb_span(self, l * self->width + a->SC, a->EC - a->SC + 1, &offset);
+				memcpy((uint8_t *)self->fram_buf + offset, (uint8_t *)self->front_buf + offset, size);
+			}
+		}
+	}
+	return mp_obj_new_int_from_uint(blocked);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_swap_obj, 1, 2, amoled_AMOLED_swap);
+
+
+//Get or set palette entries (bpp=8 or monochrome) : palette(index) returns a color, palette(index, color) sets one,
+//palette(index, colors) sets len(colors) entries from index. Colors are RGB565 as returned by colorRGB() with bpp=16.
+static mp_obj_t amoled_AMOLED_palette(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	mp_int_t index = mp_obj_get_int(args[1]);
+
+	if (self->lut == NULL) {
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("No palette, frame buffer holds colors."));
+	}
+	if ((index < 0) || (index >= (1 << self->fram_bpp))) {
+		mp_raise_ValueError(MP_ERROR_TEXT("palette index out of range"));
+	}
+	if (n_args == 2) {
+		return MP_OBJ_NEW_SMALL_INT(self->lut[index]);
+	}
+
+	size_t len = 1;
+	mp_obj_t *colors = (mp_obj_t *)&args[2];
+	if (!mp_obj_is_int(args[2])) {
+		mp_obj_get_array(args[2], &len, &colors);
+	}
+	if (index + len > (1 << self->fram_bpp)) {
+		mp_raise_ValueError(MP_ERROR_TEXT("palette index out of range"));
+	}
+	for (size_t i = 0; i < len; i++) {
+		self->lut[index + i] = mp_obj_get_int(colors[i]);
+	}
+
+	//The panel holds expanded colors, any pixel may have changed without the frame buffer changing
+	shadow_invalidate(self);
+	if ((!self->hold_display) && (self->auto_refresh)) {
+		refresh_display(self, 0, 0, self->width, self->height);
+	}
+	return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_palette_obj, 2, 3, amoled_AMOLED_palette);
+
+
+//Double buffer statistics : (frames presented, swap() calls that waited, present running)
+static mp_obj_t amoled_AMOLED_present_stats(mp_obj_t self_in) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	mp_obj_t stats[3] = {
+		mp_obj_new_int_from_uint(self->present_frames),
+		mp_obj_new_int_from_uint(self->present_blocked),
+		mp_obj_new_bool(self->present.busy)
+	};
+	return mp_obj_new_tuple(3, stats);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_AMOLED_present_stats_obj, amoled_AMOLED_present_stats);
+
+
+//Refresh whole (if no args) or a portion of the display (need x,y,w,h)
+static mp_obj_t amoled_AMOLED_refresh(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	amoled_area_t area;
+
+	if (n_args > 4) {	//if x0..y1 exist, only update partial area
+		if (align_area(self, mp_obj_get_int(args[1]), mp_obj_get_int(args[2]), mp_obj_get_int(args[3]),  mp_obj_get_int(args[4]), &area)) {
+			present_wait(self);
+			pace_frame(self);
+			send_area(self, &area);
+		}
+	} else if (self->front_buf) {	//double buffer : present the whole frame and copy it to the back buffer
+		amoled_AMOLED_swap(2, (mp_obj_t[]) { args[0], mp_const_true });
+		return mp_const_none;
+	} else {			//otherwise update full screen, pending damaged areas are included
+		self->damage_count = 0;
+		if (self->tile_map) {
+			memset(self->tile_map, 0, (self->tile_cols * self->tile_rows + 7) >> 3);
+			self->tile_dirty = 0;
+		}
+		align_area(self, 0, 0, self->width, self->height, &area);
+		pace_frame(self);
+		send_area(self, &area);
+	}
+	trace_frame(self);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_refresh_obj, 1, 5, amoled_AMOLED_refresh);
+
+
+//Send the damaged areas accumulated in AUTO_REFRESH_DEFERRED mode
+static mp_obj_t amoled_AMOLED_flush(mp_obj_t self_in) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	if (self->front_buf) {		//double buffer : damaged areas are presented by swap()
+		amoled_AMOLED_swap(1, &self_in);
+		return mp_const_none;
+	}
+	if (self->damage_count || self->tile_dirty) {
+		pace_frame(self);
+	}
+	flush_damage(self);
+	trace_frame(self);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_AMOLED_flush_obj, amoled_AMOLED_flush);
+
+
+//Get or set auto_refresh mode, leaving AUTO_REFRESH_DEFERRED flushes the pending areas.
+//Double buffer : they are kept for the next swap(), flushing would send the back buffer
+static mp_obj_t amoled_AMOLED_auto_refresh(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+
+	if (n_args > 1) {
+		mp_int_t mode = mp_obj_get_int(args[1]);
+		if ((mode < AUTO_REFRESH_OFF) || (mode > AUTO_REFRESH_DEFERRED)) {
+			mp_raise_ValueError(MP_ERROR_TEXT("unsupported auto_refresh mode"));
+		}
+		if ((self->front_buf || self->band_ops) && (mode == AUTO_REFRESH_ON)) {
+			mp_raise_ValueError(MP_ERROR_TEXT("auto_refresh ON is not available with double buffer or band"));
+		}
+		if ((mode != AUTO_REFRESH_DEFERRED) && (self->front_buf == NULL)) {
+			flush_damage(self);
+		}
+		self->auto_refresh = mode;
+	}
+    return mp_obj_new_int(self->auto_refresh);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_auto_refresh_obj, 1, 2, amoled_AMOLED_auto_refresh);
+
+
+//Damage statistics : (areas added, areas flushed, bytes requested, bytes sent, bytes saved), reset if arg is True
+static mp_obj_t amoled_AMOLED_damage_stats(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	mp_obj_t stats[5] = {
+		mp_obj_new_int_from_uint(self->damage_added),
+		mp_obj_new_int_from_uint(self->damage_flushed),
+		mp_obj_new_int_from_ull(self->damage_requested),
+		mp_obj_new_int_from_ull(self->damage_sent),
+		mp_obj_new_int_from_ll((long long)self->damage_requested - (long long)self->damage_sent)
+	};
+
+	if ((n_args > 1) && mp_obj_is_true(args[1])) {
+		self->damage_added     = 0;
+		self->damage_flushed   = 0;
+		self->damage_requested = 0;
+		self->damage_sent      = 0;
+	}
+	return mp_obj_new_tuple(5, stats);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_damage_stats_obj, 1, 2, amoled_AMOLED_damage_stats);
+
+
+//Start the bus trace with a ring of n records (0 stops it), returns (records held, records added, records lost)
+static mp_obj_t amoled_AMOLED_trace(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+
+	present_wait(self);		//the present worker records in trace_buf too
+	if (n_args > 1) {
+		mp_int_t size = mp_obj_get_int(args[1]);
+		if (size < 0) {
+			mp_raise_ValueError(MP_ERROR_TEXT("trace size must be positive"));
+		}
+		heap_caps_free((void*)self->trace_buf);
+		self->trace_buf = NULL;
+		self->trace_size = 0;
+		self->trace_total = 0;
+		self->trace_frame = 0;
+		if (size > 0) {
+			self->trace_buf = heap_caps_malloc(size * sizeof(amoled_trace_rec_t), MALLOC_CAP_8BIT);
+			if (self->trace_buf == NULL) {
+				mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to allocate trace buffer."));
+			}
+			self->trace_size = size;
+		}
+	}
+
+	uint32_t held = MIN(self->trace_total, self->trace_size);
+	mp_obj_t stats[3] = {
+		mp_obj_new_int_from_uint(held),
+		mp_obj_new_int_from_uint(self->trace_total),
+		mp_obj_new_int_from_uint(self->trace_total - held)
+	};
+	return mp_obj_new_tuple(3, stats);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_trace_obj, 1, 2, amoled_AMOLED_trace);
+
+
+//Enable the shadow GRAM diff with cells of band columns (even, 0 disables it), returns the band in use
+static mp_obj_t amoled_AMOLED_shadow(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+
+	if (n_args > 1) {
+		mp_int_t band = mp_obj_get_int(args[1]);
+		if ((band < 0) || (band & 1) || (band > MAX(self->width, self->height))) {
+			mp_raise_ValueError(MP_ERROR_TEXT("band must be even and fit the display"));
+		}
+		if (self->band_ops) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("shadow GRAM needs a frame buffer"));
+		}
+		present_wait(self);
+		heap_caps_free((void*)self->shadow_hash);
+		self->shadow_hash = NULL;
+		self->shadow_band = 0;
+		if (band > 0) {
+			uint16_t side = MAX(self->width, self->height);		//any rotation fits
+			self->shadow_cols = (side + band - 1) / band;
+			self->shadow_pairs = side >> 1;
+			self->shadow_hash = heap_caps_calloc(self->shadow_cols * self->shadow_pairs, sizeof(uint32_t), MALLOC_CAP_8BIT);
+			if (self->shadow_hash == NULL) {
+				mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Failed to allocate shadow hashes."));
+			}
+			self->shadow_band = band;
+		}
+	}
+	return mp_obj_new_int(self->shadow_band);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_shadow_obj, 1, 2, amoled_AMOLED_shadow);
+
+
+//Shadow statistics : (rows compared, rows skipped, bytes requested, bytes sent, bytes saved), reset if arg is True
+static mp_obj_t amoled_AMOLED_shadow_stats(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	mp_obj_t stats[5] = {
+		mp_obj_new_int_from_uint(self->shadow_rows),
+		mp_obj_new_int_from_uint(self->shadow_skipped),
+		mp_obj_new_int_from_ull(self->shadow_requested),
+		mp_obj_new_int_from_ull(self->shadow_sent),
+		mp_obj_new_int_from_ll((long long)self->shadow_requested - (long long)self->shadow_sent)
+	};
+
+	if ((n_args > 1) && mp_obj_is_true(args[1])) {
+		self->shadow_rows      = 0;
+		self->shadow_skipped   = 0;
+		self->shadow_requested = 0;
+		self->shadow_sent      = 0;
+	}
+	return mp_obj_new_tuple(5, stats);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_shadow_stats_obj, 1, 2, amoled_AMOLED_shadow_stats);
+
+
+//Band mode statistics : (fills held, fills the list can hold, strips sent, fills drawn into strips), reset if arg is True
+static mp_obj_t amoled_AMOLED_band_stats(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	mp_obj_t stats[4] = {
+		mp_obj_new_int_from_uint(self->band_count),
+		mp_obj_new_int_from_uint(self->band_ops ? self->band_size : 0),
+		mp_obj_new_int_from_uint(self->band_strips),
+		mp_obj_new_int_from_uint(self->band_replayed)
+	};
+
+	if ((n_args > 1) && mp_obj_is_true(args[1])) {
+		self->band_strips   = 0;
+		self->band_replayed = 0;
+	}
+	return mp_obj_new_tuple(4, stats);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_band_stats_obj, 1, 2, amoled_AMOLED_band_stats);
+
+
+//Write the trace records, oldest first, to a file (replay it with tools/amoled_trace.py)
+static mp_obj_t amoled_AMOLED_trace_dump(mp_obj_t self_in, mp_obj_t filename_in) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	const char *filename = mp_obj_str_get_str(filename_in);
+
+	present_wait(self);		//no record added while the ring is written out
+	if (self->trace_buf == NULL) {
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Trace is not started."));
+	}
+
+	uint32_t held = MIN(self->trace_total, self->trace_size);
+	uint32_t first = self->trace_total - held;
+	uint32_t lost = first;
+
+	// Header : magic, version, record size, records, records lost (little endian)
+	uint8_t header[16] = { 'A', 'M', 'T', 'R', TRACE_VERSION, 0, sizeof(amoled_trace_rec_t), 0,
+						   held, held >> 8, held >> 16, held >> 24,
+						   lost, lost >> 8, lost >> 16, lost >> 24 };
+
+	mp_file_t *fp = mp_open(filename, "wb");
+	mp_write(fp, header, sizeof(header));
+
+	// The ring is written in at most 2 contiguous parts
+	uint32_t start = first % self->trace_size;
+	uint32_t part = MIN(held, self->trace_size - start);
+	mp_write(fp, &self->trace_buf[start], part * sizeof(amoled_trace_rec_t));
+	if (held > part) {
+		mp_write(fp, self->trace_buf, (held - part) * sizeof(amoled_trace_rec_t));
+	}
+	mp_close(fp);
+
+	return mp_obj_new_int_from_uint(held);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_2(amoled_AMOLED_trace_dump_obj, amoled_AMOLED_trace_dump);
+
+
+// This fill the frame buffer area, it has no dimension check, all should be done previously
+static void fill_frame_buffer(amoled_AMOLED_obj_t *self, uint16_t color, uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+	
+	size_t fram_buf_idx;
+
+	color = fb_color(self, color);
+	if (self->band_ops) {	//band mode : recorded, drawn when the area is sent
+		band_add(self, x, y, w, h, color);
+	} else {
+		if (self->fram_buf == NULL) {
+			mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("No framebuffer available."));
+		}
+		for (uint16_t line = 0; line < h; line++) {
+			fram_buf_idx = ((y + line) * self->width) + x;
+			if (self->fram_bpp == 8) {
+				memset((uint8_t *)self->fram_buf + fram_buf_idx, color, w);
+			} else if (self->fram_bpp < 8) {	//byte pattern of the gray level (0xFF / 0x55 / 0x11 per level)
+				amoled_fill_bits((uint8_t *)self->fram_buf, fram_buf_idx * self->fram_bpp, w * self->fram_bpp, color * (0xFF / ((1 << self->fram_bpp) - 1)));
+			} else {
+				amoled_fill16(&self->fram_buf[fram_buf_idx], color, w);
+			}
+		}
+	}
+
+    if ((!self->hold_display) && (self->auto_refresh)) {
+		refresh_display(self,x,y,w,h);
+	}
+}
+
+
+/*-----------------------------------------------------------------------------------------------------
+Below are drawing functions : Pixel, lines, rectangles, filled circles, a.s.o
+------------------------------------------------------------------------------------------------------*/
+
+
+static void pixel(amoled_AMOLED_obj_t *self, uint16_t x, uint16_t y, uint16_t color) {
+	uint32_t fram_buf_idx;
+	if ((x < self->width) & (y < self->height)) {
+		fram_buf_idx = (y * self->width) + x;
+		fb_put(self, fram_buf_idx, fb_color(self, color));
+		if (!self->hold_display && self->auto_refresh) {
+			refresh_display(self,x,y,1,1);
+		}
+	}
+}
+
+static mp_obj_t amoled_AMOLED_pixel(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    uint16_t x = mp_obj_get_int(args[1]);
+    uint16_t y = mp_obj_get_int(args[2]);
+    uint16_t color = mp_obj_get_int(args[3]);
+
+    pixel(self, x, y, color);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_pixel_obj, 4, 4, amoled_AMOLED_pixel);
+
+
+static mp_obj_t amoled_AMOLED_fill(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    uint16_t color = mp_obj_get_int(args[1]);
+	
     fill_frame_buffer(self, color, 0, 0, self->width, self->height);
     return mp_const_none;
 }
@@ -839,74 +1956,137 @@ static mp_obj_t amoled_AMOLED_vline(size_t n_args, const mp_obj_t *args) {
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_vline_obj, 5, 5, amoled_AMOLED_vline);
 
 
-static void line(amoled_AMOLED_obj_t *self, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color) {
-    bool steep = ABS(y1 - y0) > ABS(x1 - x0);
-	bool saved_hold_display = self->hold_display;
-	
-    if (steep) {
-        SWAP16(x0, y0);
-        SWAP16(x1, y1);
-    }
+//Cohen-Sutherland region of a point against the display
+#define CLIP_LEFT	1
+#define CLIP_RIGHT	2
+#define CLIP_TOP	4
+#define CLIP_BOTTOM	8
 
-    if (x0 > x1) {
-        SWAP16(x0, x1);
-        SWAP16(y0, y1);
-    }
+static uint8_t clip_code(amoled_AMOLED_obj_t *self, int x, int y) {
+	return ((x < 0) ? CLIP_LEFT : 0) | ((x >= self->width) ? CLIP_RIGHT : 0) |
+		   ((y < 0) ? CLIP_TOP : 0) | ((y >= self->height) ? CLIP_BOTTOM : 0);
+}
 
-    int16_t dx = x1 - x0, dy = ABS(y1 - y0);
-    int16_t err = dx >> 1, ystep = -1, xs = x0, dlen = 0;
+//Clip a segment to the display (Cohen-Sutherland), false when nothing is left
+static bool clip_line(amoled_AMOLED_obj_t *self, int *x0, int *y0, int *x1, int *y1) {
+	int xmax = self->width - 1;
+	int ymax = self->height - 1;
+	uint8_t code0 = clip_code(self, *x0, *y0);
+	uint8_t code1 = clip_code(self, *x1, *y1);
 
-    if (y0 < y1) {
-        ystep = 1;
-    }
-	
-	self->hold_display = true;
-	
-    // Split into steep and not steep for FastH/V separation
-    if (steep) {
-        for (; x0 <= x1; x0++) {
-            dlen++;
-            err -= dy;
-            if (err < 0) {
-                err += dx;
-                fast_vline(self, y0, xs, dlen, color);
-                dlen = 0;
-                y0 += ystep;
-                xs = x0 + 1;
-            }
-        }
-        if (dlen) {
-            fast_vline(self, y0, xs, dlen, color);
-        }
-    } else {
-        for (; x0 <= x1; x0++) {
-            dlen++;
-            err -= dy;
-            if (err < 0) {
-                err += dx;
-                fast_hline(self, xs, y0, dlen, color);
-                dlen = 0;
-                y0 += ystep;
-                xs = x0 + 1;
-            }
-        }
-        if (dlen) {
-            fast_hline(self, xs, y0, dlen, color);
-        }
-    }
-	// Restore hold_display status
-	self->hold_display = saved_hold_display;
-	if (!self->hold_display & self->auto_refresh) {
-		refresh_display(self,x0,y0,x1-x0,(y1>y0)?(y1-y0):(y0-y1));
+	while (code0 | code1) {
+		if (code0 & code1) {
+			return false;	//both ends on the same outer side
+		}
+		uint8_t code = code0 ? code0 : code1;
+		int64_t dx = *x1 - *x0, dy = *y1 - *y0;
+		int x, y;
+
+		if (code & CLIP_BOTTOM) {
+			x = *x0 + dx * (ymax - *y0) / dy;
+			y = ymax;
+		} else if (code & CLIP_TOP) {
+			x = *x0 + dx * (0 - *y0) / dy;
+			y = 0;
+		} else if (code & CLIP_RIGHT) {
+			y = *y0 + dy * (xmax - *x0) / dx;
+			x = xmax;
+		} else {
+			y = *y0 + dy * (0 - *x0) / dx;
+			x = 0;
+		}
+		if (code == code0) {
+			*x0 = x;
+			*y0 = y;
+			code0 = clip_code(self, x, y);
+		} else {
+			*x1 = x;
+			*y1 = y;
+			code1 = clip_code(self, x, y);
+		}
+	}
+	return true;
+}
+
+//Draw a run of a line, already clipped, color is a frame buffer color
+static void line_run(amoled_AMOLED_obj_t *self, int x, int y, int w, int h, uint16_t color) {
+	size_t idx = y * self->width + x;
+	uint16_t *row = fb_row16(self, idx);
+
+	if (self->band_ops) {
+		band_add(self, x, y, w, h, color);
+	} else if (row) {
+		if (h == 1) {
+			amoled_fill16(row, color, w);
+		} else {
+			for (; h; h--, row += self->width) {
+				*row = color;
+			}
+		}
+	} else {
+		for (int l = 0; l < h; l++, idx += self->width) {
+			for (int c = 0; c < w; c++) {
+				fb_put(self, idx + c, color);
+			}
+		}
+	}
+}
+
+//Bresenham line clipped to the display, drawn by runs straight into the frame buffer
+static void line(amoled_AMOLED_obj_t *self, int x0, int y0, int x1, int y1, uint16_t color) {
+	int t;
+
+	if (!clip_line(self, &x0, &y0, &x1, &y1)) {
+		return;
+	}
+	if ((self->fram_buf == NULL) && (self->band_ops == NULL)) {
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("No framebuffer available."));
+	}
+	color = fb_color(self, color);
+
+	//area to refresh
+	int xmin = MIN(x0, x1), ymin = MIN(y0, y1);
+	int w = ABS(x1 - x0) + 1, h = ABS(y1 - y0) + 1;
+	bool steep = h > w;
+
+	// Split into steep and not steep for vertical or horizontal runs
+	if (steep) {
+		t = x0; x0 = y0; y0 = t;
+		t = x1; x1 = y1; y1 = t;
+	}
+	if (x0 > x1) {
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+
+	int dx = x1 - x0, dy = ABS(y1 - y0);
+	int err = dx >> 1, ystep = (y0 < y1) ? 1 : -1, xs = x0;
+
+	for (int x = x0; x <= x1; x++) {
+		err -= dy;
+		if ((err < 0) || (x == x1)) {	//end of a run
+			if (steep) {
+				line_run(self, y0, xs, 1, x - xs + 1, color);
+			} else {
+				line_run(self, xs, y0, x - xs + 1, 1, color);
+			}
+			err += dx;
+			y0 += ystep;
+			xs = x + 1;
+		}
+	}
+
+	if (!self->hold_display && self->auto_refresh) {
+		refresh_display(self, xmin, ymin, w, h);
 	}
 }
 
 static mp_obj_t amoled_AMOLED_line(size_t n_args, const mp_obj_t *args) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    uint16_t x0 = mp_obj_get_int(args[1]);
-    uint16_t y0 = mp_obj_get_int(args[2]);
-    uint16_t x1 = mp_obj_get_int(args[3]);
-    uint16_t y1 = mp_obj_get_int(args[4]);
+    mp_int_t x0 = mp_obj_get_int(args[1]);
+    mp_int_t y0 = mp_obj_get_int(args[2]);
+    mp_int_t x1 = mp_obj_get_int(args[3]);
+    mp_int_t y1 = mp_obj_get_int(args[4]);
     uint16_t color = mp_obj_get_int(args[5]);
 
     line(self, x0, y0, x1, y1, color);
@@ -1093,180 +2273,169 @@ static mp_obj_t amoled_AMOLED_fill_trian(size_t n_args, const mp_obj_t *args) {
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_fill_trian_obj, 8, 8, amoled_AMOLED_fill_trian);
 
 
-static void bubble_rect(amoled_AMOLED_obj_t *self, uint16_t xs, uint16_t ys, uint16_t w, uint16_t h, uint16_t color) {
-    if (xs + w > self->width || ys + h > self->height) {
-        return;
-    }
+//Shapes below are drawn by runs clipped to the display and written straight into the frame buffer,
+//then refreshed once. Corners of round rectangles are quarters of a circle of radius r around
+//(xl, yt), (xr, yt), (xl, yb) and (xr, yb), a circle is the round rectangle xl = xr, yt = yb.
 
-    int bubble_size = min_val(w, h) / 4; 
-    int xm = xs + bubble_size;
-    int ym = ys + bubble_size;
-    
-	self->hold_display = true;
-	
-	//Process sides
-
-	fast_hline(self, xm, ys, w - bubble_size * 2, color);
-	fast_hline(self, xm, ys + h - 1, w - bubble_size * 2, color);
-	fast_vline(self, xs, ym , h - bubble_size * 2, color);
-    fast_vline(self, xs + w -1, ym , h - bubble_size * 2, color);
-
-	//Process angles
-	if(bubble_size > 1) {
-		/*int x = 0;
-		int y = bubble_size;
-		int p = 1 - bubble_size;  p is always <0 at beginning so avoid processins x=0*/
-		int x = 1;
-		int y = bubble_size;
-		int p = 6 - bubble_size;  // p=(1 - bubble_size) +2x + 3 = 6-bubble_size
-		
-		while (x <= y){
-			// top left
-			pixel(self, xm - x, ym - y, color);
-			pixel(self, xm - y, ym - x, color);
-			
-			// top right
-			pixel(self, xm + w - bubble_size * 2 + x - 1, ym - y, color);
-			pixel(self, xm + w - bubble_size * 2 + y - 1, ym - x, color);
-			
-			// bottom left
-			pixel(self, xm - x, ym + h - bubble_size * 2 + y - 1, color);
-			pixel(self, xm - y, ym + h - bubble_size * 2 + x - 1, color);
-			
-			// bottom right
-			pixel(self, xm + w - bubble_size * 2 + x - 1, ym + h - bubble_size * 2 + y - 1, color);
-			pixel(self, xm + w - bubble_size * 2 + y - 1, ym + h - bubble_size * 2 + x - 1, color);
-			
-			if (p < 0) {
-				p += 2 * x + 3;
-			} else {
-				p += 2 * (x - y) + 5;
-				y -= 1;
-			}
-			x += 1;
-		}
+//Horizontal run from x0 to x1 clipped to the display, color is a frame buffer color
+static void shape_span(amoled_AMOLED_obj_t *self, int x0, int x1, int y, uint16_t color) {
+	if ((y < 0) || (y >= self->height)) {
+		return;
 	}
-	
-	self->hold_display = false;
-	refresh_display(self,xs,ys,w,h);
+	x0 = MAX(x0, 0);
+	x1 = MIN(x1, self->width - 1);
+	if (x0 <= x1) {
+		line_run(self, x0, y, x1 - x0 + 1, 1, color);
+	}
+}
+
+//Check the frame buffer and convert the color once per shape
+static uint16_t shape_begin(amoled_AMOLED_obj_t *self, uint16_t color) {
+	if ((self->fram_buf == NULL) && (self->band_ops == NULL)) {
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("No framebuffer available."));
+	}
+	return fb_color(self, color);
+}
+
+static void shape_end(amoled_AMOLED_obj_t *self, int x, int y, int w, int h) {
+	if (!self->hold_display) {
+		refresh_display(self, x, y, w, h);
+	}
+}
+
+//Outline of a round rectangle (midpoint circle)
+static void round_outline(amoled_AMOLED_obj_t *self, int xl, int xr, int yt, int yb, int r, uint16_t color) {
+	int x = 0, y = r, p = 1 - r;
+
+	shape_span(self, xl, xr, yt - r, color);		//straight sides
+	shape_span(self, xl, xr, yb + r, color);
+	for (int l = yt; l <= yb; l++) {
+		shape_span(self, xl - r, xl - r, l, color);
+		shape_span(self, xr + r, xr + r, l, color);
+	}
+	while (x <= y) {
+		shape_span(self, xr + x, xr + x, yb + y, color);
+		shape_span(self, xr + x, xr + x, yt - y, color);
+		shape_span(self, xl - x, xl - x, yb + y, color);
+		shape_span(self, xl - x, xl - x, yt - y, color);
+		shape_span(self, xr + y, xr + y, yb + x, color);
+		shape_span(self, xr + y, xr + y, yt - x, color);
+		shape_span(self, xl - y, xl - y, yb + x, color);
+		shape_span(self, xl - y, xl - y, yt - x, color);
+		if (p < 0) {
+			p += 2 * x + 3;
+		} else {
+			p += 2 * (x - y) + 5;
+			y -= 1;
+		}
+		x += 1;
+	}
+}
+
+//Filled round rectangle, every row is written once
+static void round_fill(amoled_AMOLED_obj_t *self, int xl, int xr, int yt, int yb, int r, uint16_t color) {
+	int x = 0, y = r, p = 1 - r;
+
+	for (int l = yt + 1; l < yb; l++) {		//straight part
+		shape_span(self, xl - r, xr + r, l, color);
+	}
+	while (x <= y) {
+		//rows x away from the centers are y wide
+		shape_span(self, xl - y, xr + y, yb + x, color);
+		if ((x) || (yt != yb)) {
+			shape_span(self, xl - y, xr + y, yt - x, color);
+		}
+		if (p < 0) {
+			p += 2 * x + 3;
+		} else {
+			//last point on rows y away from the centers, the widest one
+			if (y > x) {
+				shape_span(self, xl - x, xr + x, yb + y, color);
+				shape_span(self, xl - x, xr + x, yt - y, color);
+			}
+			p += 2 * (x - y) + 5;
+			y -= 1;
+		}
+		x += 1;
+	}
+}
+
+//Round rectangle corner radius : r, or w / 4 when r < 0, at most half of the smallest side
+static int round_radius(int w, int h, int r) {
+	if (r < 0) {
+		r = min_val(w, h) / 4;
+	}
+	return min_val(r, (min_val(w, h) - 1) / 2);
 }
 
+static void bubble_rect(amoled_AMOLED_obj_t *self, int xs, int ys, int w, int h, uint16_t color, int r) {
+	if ((w < 1) || (h < 1)) {
+		return;
+	}
+	r = round_radius(w, h, r);
+	color = shape_begin(self, color);
+	round_outline(self, xs + r, xs + w - 1 - r, ys + r, ys + h - 1 - r, r, color);
+	shape_end(self, xs, ys, w, h);
+}
+
+//	bubble_rect(x, y, w, h, color[, r])
 static mp_obj_t amoled_AMOLED_bubble_rect(size_t n_args, const mp_obj_t *args) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    uint16_t x = mp_obj_get_int(args[1]);
-    uint16_t y = mp_obj_get_int(args[2]);
-    uint16_t w = mp_obj_get_int(args[3]);
-    uint16_t h = mp_obj_get_int(args[4]);
+    mp_int_t x = mp_obj_get_int(args[1]);
+    mp_int_t y = mp_obj_get_int(args[2]);
+    mp_int_t w = mp_obj_get_int(args[3]);
+    mp_int_t h = mp_obj_get_int(args[4]);
     uint16_t color = mp_obj_get_int(args[5]);
+    mp_int_t r = (n_args > 6) ? mp_obj_get_int(args[6]) : -1;
 
-    bubble_rect(self, x, y, w, h, color);
+    bubble_rect(self, x, y, w, h, color, r);
     return mp_const_none;
 }
 
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_bubble_rect_obj, 6, 6, amoled_AMOLED_bubble_rect);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_bubble_rect_obj, 6, 7, amoled_AMOLED_bubble_rect);
 
 
-static void fill_bubble_rect(amoled_AMOLED_obj_t *self, uint16_t xs, uint16_t ys, uint16_t w, uint16_t h, uint16_t color) {
-    if (xs + w > self->width || ys + h > self->height) {
-        return;
-    }
-    int bubble_size = min_val(w, h) / 4; 
-    int xm = xs + bubble_size;
-    int ym = ys + bubble_size;
-    
-	self->hold_display = true;
-	
-	//Process internal rectangle
-    fill_rect(self, xs, ym, w, h - bubble_size * 2, color);
-
-	//Process upper and lower rounded rectangles
-	if(bubble_size >= 1) {
-		/*int x = 0;
-		int y = bubble_size;
-		int p = 1 - bubble_size;  p is always <0 at beginning so avoid processins x=0*/
-		int x = 1;
-		int y = bubble_size;
-		int p = 6 - bubble_size;  // p=(1 - bubble_size) +2x + 3 = 6-bubble_size
-
-
-		while (x <= y) {
-			// top left to right
-			fast_hline(self, xm - x, ym - y, w - bubble_size * 2 + x * 2 - 1, color);
-			fast_hline(self, xm - y, ym - x, w - bubble_size * 2 + y * 2 - 1, color);
-			
-			// bottom left to right
-			fast_hline(self, xm - x, ym + h - bubble_size * 2 + y - 1, w - bubble_size * 2 + x * 2 - 1, color);
-			fast_hline(self, xm - y, ym + h - bubble_size * 2 + x - 1, w - bubble_size * 2 + y * 2 - 1, color);
-			
-			if (p < 0) {
-				p += 2 * x + 3;
-			} else {
-				p += 2 * (x - y) + 5;
-				y -= 1;
-			} 
-			x += 1;
-		}
+static void fill_bubble_rect(amoled_AMOLED_obj_t *self, int xs, int ys, int w, int h, uint16_t color, int r) {
+	if ((w < 1) || (h < 1)) {
+		return;
 	}
-	self->hold_display = false;
-	refresh_display(self,xs,ys,w,h);
+	r = round_radius(w, h, r);
+	color = shape_begin(self, color);
+	round_fill(self, xs + r, xs + w - 1 - r, ys + r, ys + h - 1 - r, r, color);
+	shape_end(self, xs, ys, w, h);
 }
 
+//	fill_bubble_rect(x, y, w, h, color[, r])
 static mp_obj_t amoled_AMOLED_fill_bubble_rect(size_t n_args, const mp_obj_t *args) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    uint16_t x = mp_obj_get_int(args[1]);
-    uint16_t y = mp_obj_get_int(args[2]);
-    uint16_t w = mp_obj_get_int(args[3]);
-    uint16_t h = mp_obj_get_int(args[4]);
+    mp_int_t x = mp_obj_get_int(args[1]);
+    mp_int_t y = mp_obj_get_int(args[2]);
+    mp_int_t w = mp_obj_get_int(args[3]);
+    mp_int_t h = mp_obj_get_int(args[4]);
     uint16_t color = mp_obj_get_int(args[5]);
+    mp_int_t r = (n_args > 6) ? mp_obj_get_int(args[6]) : -1;
 
-    fill_bubble_rect(self, x, y, w, h, color);
+    fill_bubble_rect(self, x, y, w, h, color, r);
     return mp_const_none;
 }
 
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_fill_bubble_rect_obj, 6, 6, amoled_AMOLED_fill_bubble_rect);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_fill_bubble_rect_obj, 6, 7, amoled_AMOLED_fill_bubble_rect);
 
 
-static void circle(amoled_AMOLED_obj_t *self, uint16_t xm, uint16_t ym, uint16_t r, uint16_t color) {
-    
-	self->hold_display = true;
-	
-	if (r == 0){
-		pixel(self, xm , ym , color);
-	}
-	else {
-		int x = 0;
-		int y = r;
-		int p = 1 - r;	
-
-		while (x <= y) {
-			pixel(self, xm + x, ym + y, color);
-			pixel(self, xm + x, ym - y, color);
-			pixel(self, xm - x, ym + y, color);
-			pixel(self, xm - x, ym - y, color);
-			pixel(self, xm + y, ym + x, color);
-			pixel(self, xm + y, ym - x, color);
-			pixel(self, xm - y, ym + x, color);
-			pixel(self, xm - y, ym - x, color);
-
-			if (p < 0) {
-				p += 2 * x + 3;
-			} else {
-				p += 2 * (x - y) + 5;
-				y -= 1;
-			}
-			x += 1;
-		}
+static void circle(amoled_AMOLED_obj_t *self, int xm, int ym, int r, uint16_t color) {
+	if (r < 0) {
+		return;
 	}
-	
-	self->hold_display = false;
-	refresh_display(self,xm-r,ym-r,2*r+1,2*r+1);
+	color = shape_begin(self, color);
+	round_outline(self, xm, xm, ym, ym, r, color);
+	shape_end(self, xm - r, ym - r, 2 * r + 1, 2 * r + 1);
 }
 
 static mp_obj_t amoled_AMOLED_circle(size_t n_args, const mp_obj_t *args) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    uint16_t xm = mp_obj_get_int(args[1]);
-    uint16_t ym = mp_obj_get_int(args[2]);
-    uint16_t r = mp_obj_get_int(args[3]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t r = mp_obj_get_int(args[3]);
     uint16_t color = mp_obj_get_int(args[4]);
 
     circle(self, xm, ym, r, color);
@@ -1275,43 +2444,20 @@ static mp_obj_t amoled_AMOLED_circle(size_t n_args, const mp_obj_t *args) {
 
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_circle_obj, 5, 5, amoled_AMOLED_circle);
 
-static void fill_circle(amoled_AMOLED_obj_t *self, uint16_t xm, uint16_t ym, uint16_t r, uint16_t color) {
-	
- 	self->hold_display = true;
-	
-	if (r == 0){
-		pixel(self, xm , ym , color);
-	}
-	else {
-		int x = 0;
-		int y = r;
-		int p = 1 - r;
-		
-		while (x <= y) {
-			fast_vline(self, xm + x, ym - y, 2 * y, color);
-			fast_vline(self, xm - x, ym - y, 2 * y, color);
-			fast_vline(self, xm + y, ym - x, 2 * x, color);
-			fast_vline(self, xm - y, ym - x, 2 * x, color);
-
-			if (p < 0) {
-				p += 2 * x + 3;
-			} else {
-				p += 2 * (x - y) + 5;
-				y -= 1;
-			}
-			x += 1;
-		}
+static void fill_circle(amoled_AMOLED_obj_t *self, int xm, int ym, int r, uint16_t color) {
+	if (r < 0) {
+		return;
 	}
-	
-	self->hold_display = false;
-	refresh_display(self,xm-r,ym-r,2*r+1,2*r+1);
+	color = shape_begin(self, color);
+	round_fill(self, xm, xm, ym, ym, r, color);
+	shape_end(self, xm - r, ym - r, 2 * r + 1, 2 * r + 1);
 }
 
 static mp_obj_t amoled_AMOLED_fill_circle(size_t n_args, const mp_obj_t *args) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    uint16_t xm = mp_obj_get_int(args[1]);
-    uint16_t ym = mp_obj_get_int(args[2]);
-    uint16_t r = mp_obj_get_int(args[3]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t r = mp_obj_get_int(args[3]);
     uint16_t color = mp_obj_get_int(args[4]);
 
     fill_circle(self, xm, ym, r, color);
@@ -1321,240 +2467,505 @@ static mp_obj_t amoled_AMOLED_fill_circle(size_t n_args, const mp_obj_t *args) {
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_fill_circle_obj, 5, 5, amoled_AMOLED_fill_circle);
 
 
-static void ellipse(amoled_AMOLED_obj_t *self, uint16_t xm, uint16_t ym, uint16_t rx, uint16_t ry, uint16_t color) {
-
-	self->hold_display = true;
-
-	//If ellipse is flat, général algorythm will fall into loop
-	if ((rx == 0)|(ry == 0)){
-		if (rx == 0) {
-			fast_hline(self, xm - ry, ym, 2 * ry, color);
-		}
-		if (ry == 0){
-			fast_vline(self, xm, ym-rx, 2 * rx, color);
+//Midpoint ellipse : calls plot(x, y) for the points of a quarter, x going up while y goes down.
+//With filled, only the widest point of every y is given.
+static void ellipse_spans(amoled_AMOLED_obj_t *self, int xm, int ym, int rx, int ry, uint16_t color, bool filled) {
+	int64_t rx2 = (int64_t)rx * rx, ry2 = (int64_t)ry * ry;
+	int x = 0, y = ry;
+	int64_t dx = 0, dy = 2 * rx2 * y;
+	int64_t d1 = 4 * ry2 - 4 * rx2 * ry + rx2;		// 4 times the midpoint decision
+
+	// Region 1, slope under 1 : x moves every step
+	while (dx <= dy) {
+		if (!filled) {
+			shape_span(self, xm + x, xm + x, ym + y, color);
+			shape_span(self, xm - x, xm - x, ym + y, color);
+			shape_span(self, xm + x, xm + x, ym - y, color);
+			shape_span(self, xm - x, xm - x, ym - y, color);
 		}
-	}
-	else {
-		
-		int x = 0;
-		int y = ry;
-	
-		//let to check vs int
-		float d1 = (ry * ry) - (rx * rx * ry) + (0.25 * rx * rx);
-		float dx = 0;
-		float dy = 2 * rx * rx * y;
-		
-		// Plotting points of region 1	
-		while (dx <= dy) {
-			pixel(self, xm + x, ym + y, color);
-			pixel(self, xm + x, ym - y, color);
-			pixel(self, xm - x, ym + y, color);
-			pixel(self, xm - x, ym - y, color);
-
-			if (d1 < 0) {
-				x++;
-				dx = dx + (2 * ry * ry);
-				d1 = d1 + dx + (ry * ry);
-			} 
-			else {
-				x++;
-				y--;
-				dx = dx + (2 * ry * ry);
-				dy = dy - (2 * rx * rx);
-				d1 = d1 + dx - dy + (ry * ry);
+		x++;
+		dx += 2 * ry2;
+		if (d1 < 0) {
+			d1 += 4 * (dx + ry2);
+		} else {
+			if (filled) {	//leaving row y, x - 1 was its widest point
+				shape_span(self, xm - x + 1, xm + x - 1, ym + y, color);
+				if (y) {
+					shape_span(self, xm - x + 1, xm + x - 1, ym - y, color);
+				}
 			}
+			y--;
+			dy -= 2 * rx2;
+			d1 += 4 * (dx - dy + ry2);
 		}
+	}
 
-		int d2 = ((ry * ry) * ((x + 0.5) * (x + 0.5))) + ((rx * rx) * ((y - 1) * (y - 1))) - (rx * rx * ry * ry);
-
-		// Plotting points of region 2
-		while (y >= 0) {
-			pixel(self, xm + x, ym + y, color);
-			pixel(self, xm + x, ym - y, color);
-			pixel(self, xm - x, ym + y, color);
-			pixel(self, xm - x, ym - y, color);
-			
-			if (d2 > 0) {
-				y--;
-				dy = dy - (2 * rx * rx);
-				d2 = d2 + (rx * rx) - dy;
-			} 
-			else {
-				y--;
-				x++;
-				dx = dx + (2 * ry * ry);
-				dy = dy - (2 * rx * rx);
-				d2 = d2 + dx - dy + (rx * rx);
+	// Region 2, slope over 1 : y moves every step
+	int64_t d2 = ry2 * (2 * x + 1) * (2 * x + 1) + 4 * rx2 * (y - 1) * (y - 1) - 4 * rx2 * ry2;
+	while (y >= 0) {
+		if (filled) {
+			shape_span(self, xm - x, xm + x, ym + y, color);
+			if (y) {
+				shape_span(self, xm - x, xm + x, ym - y, color);
 			}
+		} else {
+			shape_span(self, xm + x, xm + x, ym + y, color);
+			shape_span(self, xm - x, xm - x, ym + y, color);
+			shape_span(self, xm + x, xm + x, ym - y, color);
+			shape_span(self, xm - x, xm - x, ym - y, color);
+		}
+		y--;
+		dy -= 2 * rx2;
+		if (d2 > 0) {
+			d2 += 4 * (rx2 - dy);
+		} else {
+			x++;
+			dx += 2 * ry2;
+			d2 += 4 * (dx - dy + rx2);
 		}
 	}
+}
 
-	self->hold_display = false;
-	refresh_display(self,xm-rx,ym-ry,2*rx+1,2*ry+1);
+static void ellipse_draw(amoled_AMOLED_obj_t *self, int xm, int ym, int rx, int ry, uint16_t color, bool filled) {
+	if ((rx < 0) || (ry < 0)) {
+		return;
+	}
+	color = shape_begin(self, color);
+	if (ry == 0) {			//flat ellipses are lines
+		shape_span(self, xm - rx, xm + rx, ym, color);
+	} else if (rx == 0) {
+		for (int l = ym - ry; l <= ym + ry; l++) {
+			shape_span(self, xm, xm, l, color);
+		}
+	} else {
+		ellipse_spans(self, xm, ym, rx, ry, color, filled);
+	}
+	shape_end(self, xm - rx, ym - ry, 2 * rx + 1, 2 * ry + 1);
 }
 
 static mp_obj_t amoled_AMOLED_ellipse(size_t n_args, const mp_obj_t *args) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    uint16_t xm = mp_obj_get_int(args[1]);
-    uint16_t ym = mp_obj_get_int(args[2]);
-    uint16_t rx = mp_obj_get_int(args[3]);
-	uint16_t ry = mp_obj_get_int(args[4]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t rx = mp_obj_get_int(args[3]);
+	mp_int_t ry = mp_obj_get_int(args[4]);
     uint16_t color = mp_obj_get_int(args[5]);
 
-    ellipse(self, xm, ym, rx, ry, color);
+    ellipse_draw(self, xm, ym, rx, ry, color, false);
     return mp_const_none;
 }
 
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_ellipse_obj, 6, 6, amoled_AMOLED_ellipse);
 
 
-static void fill_ellipse(amoled_AMOLED_obj_t *self, uint16_t xm, uint16_t ym, uint16_t rx, uint16_t ry, uint16_t color) {
-	
-	self->hold_display = true;
+static mp_obj_t amoled_AMOLED_fill_ellipse(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t rx = mp_obj_get_int(args[3]);
+	mp_int_t ry = mp_obj_get_int(args[4]);
+    uint16_t color = mp_obj_get_int(args[5]);
+
+    ellipse_draw(self, xm, ym, rx, ry, color, true);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_fill_ellipse_obj, 6, 6, amoled_AMOLED_fill_ellipse);
 
-	//If ellipse is flat, général algorythm will fall into loop
-	if ((rx == 0)|(ry == 0)){
-		if (rx == 0) {
-			fast_hline(self, xm - ry, ym, 2 * ry, color);
+
+//Anti-aliased shapes below blend their edges over the frame buffer with a coverage from 0 to 255,
+//computed in integer math (Wu lines, 8.8 fixed point edges of ellipses). Coordinates are pixel centers.
+
+//Integer square root
+static uint32_t isqrt64(uint64_t n) {
+	uint64_t r = 0, bit = (uint64_t)1 << 62;
+
+	while (bit > n) {
+		bit >>= 2;
+	}
+	for (; bit; bit >>= 2) {
+		if (n >= r + bit) {
+			n -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
 		}
-		if (ry == 0){
-			fast_vline(self, xm, ym-rx, 2 * rx, color);
+	}
+	return r;
+}
+
+//Blend a frame buffer color over pixel (x, y) with a coverage alpha, clipped to the display.
+//Only plain 16 bits pixels can be read back, others are set when at least half covered.
+static void aa_plot(amoled_AMOLED_obj_t *self, int x, int y, uint16_t color, int alpha) {
+	if ((x < 0) || (y < 0) || (x >= self->width) || (y >= self->height) || (alpha <= 0)) {
+		return;
+	}
+	size_t idx = y * self->width + x;
+	uint16_t *p = fb_row16(self, idx);
+	if (p) {
+		uint8_t a = MIN(alpha, 255);
+		amoled_blend_alpha8(p, &a, color, !self->native, 1);
+	} else if (alpha >= 128) {
+		fb_put(self, idx, color);
+	}
+}
+
+//Plot (dx, dy) around (xm, ym) in the four quadrants, once for points on the axes
+static void aa_plot4(amoled_AMOLED_obj_t *self, int xm, int ym, int dx, int dy, uint16_t color, int alpha) {
+	aa_plot(self, xm + dx, ym + dy, color, alpha);
+	if (dx) {
+		aa_plot(self, xm - dx, ym + dy, color, alpha);
+	}
+	if (dy) {
+		aa_plot(self, xm + dx, ym - dy, color, alpha);
+		if (dx) {
+			aa_plot(self, xm - dx, ym - dy, color, alpha);
 		}
 	}
-	else {	
-			
-		int x = 0;
-		int y = ry;
-		
-		//let to check vs int
-		float d1 = (ry * ry) - (rx * rx * ry) + (0.25 * rx * rx);
-		float dx = 0;
-		float dy = 2 * rx * rx * y;
+}
 
-		self->hold_display = true;
+//Wu line : the error of the minor axis is a 16 bits fraction, its high byte weights the two pixels
+//on each side of the ideal line
+static void aa_line(amoled_AMOLED_obj_t *self, int x0, int y0, int x1, int y1, uint16_t color) {
+	int t;
 
-		//If ellipse is flat, général algorythm will fall into loop
-		if ((rx == 0)|(ry == 0)){
-			if (rx == 0) {
-				fast_hline(self, xm - ry, ym, 2 * ry, color);
-			}
-			if (ry == 0){
-				fast_vline(self, xm, ym-rx, 2 * rx, color);
-			}
+	if (!clip_line(self, &x0, &y0, &x1, &y1)) {
+		return;
+	}
+	if ((x0 == x1) || (y0 == y1) || (ABS(x1 - x0) == ABS(y1 - y0))) {
+		line(self, x0, y0, x1, y1, color);		//nothing to smooth, checked once clipped as clipping changes the slope
+		return;
+	}
+	color = shape_begin(self, color);
+
+	int xmin = MIN(x0, x1), ymin = MIN(y0, y1);
+	int w = ABS(x1 - x0) + 1, h = ABS(y1 - y0) + 1;
+	bool steep = h > w;
+
+	if (steep) {
+		t = x0; x0 = y0; y0 = t;
+		t = x1; x1 = y1; y1 = t;
+	}
+	if (x0 > x1) {
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+	}
+
+	int dx = x1 - x0, ystep = (y0 < y1) ? 1 : -1;
+	uint16_t err = 0;
+	uint32_t adj = ((uint32_t)ABS(y1 - y0) << 16) / MAX(dx, 1);
+
+	aa_plot(self, steep ? y0 : x0, steep ? x0 : y0, color, 255);
+	for (int x = x0 + 1; x < x1; x++) {
+		uint32_t sum = (uint32_t)err + adj;
+		if (sum > 0xFFFF) {		//carry
+			y0 += ystep;
+		}
+		err = sum;
+		int a = err >> 8;
+		if (steep) {
+			aa_plot(self, y0, x, color, 255 - a);
+			aa_plot(self, y0 + ystep, x, color, a);
+		} else {
+			aa_plot(self, x, y0, color, 255 - a);
+			aa_plot(self, x, y0 + ystep, color, a);
 		}
-		else {
+	}
+	aa_plot(self, steep ? y1 : x1, steep ? x1 : y1, color, 255);
 
-			// Plotting points of region 1	
-			while (dx <= dy) {
-				
-				fast_vline(self, xm + x, ym - y, 2 * y, color);
-				fast_vline(self, xm - x, ym - y, 2 * y, color);
-			
-				if (d1 < 0) {
-					x++;
-					dx = dx + (2 * ry * ry);
-					d1 = d1 + dx + (ry * ry);
-				} 
-				else {
-					x++;
-					y--;
-					dx = dx + (2 * ry * ry);
-					dy = dy - (2 * rx * rx);
-					d1 = d1 + dx - dy + (ry * ry);
-				}
-			}
+	shape_end(self, xmin, ymin, w, h);
+}
 
-			int d2 = ((ry * ry) * ((x + 0.5) * (x + 0.5))) + ((rx * rx) * ((y - 1) * (y - 1))) - (rx * rx * ry * ry);
+static mp_obj_t amoled_AMOLED_aa_line(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t x0 = mp_obj_get_int(args[1]);
+    mp_int_t y0 = mp_obj_get_int(args[2]);
+    mp_int_t x1 = mp_obj_get_int(args[3]);
+    mp_int_t y1 = mp_obj_get_int(args[4]);
+    uint16_t color = mp_obj_get_int(args[5]);
 
-			// Plotting points of region 2
-			while (y >= 0) {
-				
-				fast_vline(self, xm + x, ym - y, 2 * y, color);
-				fast_vline(self, xm - x, ym - y, 2 * y, color);
-				
-				if (d2 > 0) {
-					y--;
-					dy = dy - (2 * rx * rx);
-					d2 = d2 + (rx * rx) - dy;
-				} 
-				else {
-					y--;
-					x++;
-					dx = dx + (2 * ry * ry);
-					dy = dy - (2 * rx * rx);
-					d2 = d2 + dx - dy + (rx * rx);
+    aa_line(self, x0, y0, x1, y1, color);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_aa_line_obj, 6, 6, amoled_AMOLED_aa_line);
+
+
+//Half chord of an ellipse of half axes a (along the chord) and b at distance t from its center, 8.8 fixed point
+static uint32_t aa_chord(int a, int b, int t) {
+	return isqrt64((((uint64_t)((int64_t)b * b - (int64_t)t * t) * a * a) << 16) / ((uint64_t)b * b));
+}
+
+//Ellipse with anti-aliased edges. Rows up to yb (where the edge slope is 45 degrees) get their edge
+//from the half chord of the row, the flatter top and bottom from the half chord of each column.
+//An outline is one pixel wide on each side of the edge, a filled edge pixel is covered from its center
+//(half chord + 0.5), rows below yb are then filled up to the last column whose edge is under them.
+static void aa_ellipse(amoled_AMOLED_obj_t *self, int xm, int ym, int rx, int ry, uint16_t color, bool filled) {
+	if ((rx <= 0) || (ry <= 0)) {
+		ellipse_draw(self, xm, ym, rx, ry, color, filled);
+		return;
+	}
+	color = shape_begin(self, color);
+
+	int yb = (int64_t)ry * ry / isqrt64((uint64_t)rx * rx + (uint64_t)ry * ry);
+	int out = !filled, half = filled ? 0x80 : 0;
+	int xs = rx + 1, ys = -1;		//filled : column xs and the row of its edge
+
+	for (int dy = 0; dy <= ry; dy++) {
+		if (dy <= yb) {
+			uint32_t c = aa_chord(rx, ry, dy) + half;
+			int xi = c >> 8, a = c & 0xFF;
+
+			if (filled) {
+				shape_span(self, xm - xi + 1, xm + xi - 1, ym + dy, color);
+				if (dy) {
+					shape_span(self, xm - xi + 1, xm + xi - 1, ym - dy, color);
 				}
+			} else {
+				aa_plot4(self, xm, ym, xi, dy, color, 255 - a);
+			}
+			aa_plot4(self, xm, ym, xi + out, dy, color, a);
+		} else if (filled) {
+			while ((xs > 0) && (ys <= dy)) {
+				xs--;
+				ys = (aa_chord(ry, rx, xs) + half) >> 8;
+			}
+			if (ys > dy) {
+				shape_span(self, xm - xs, xm + xs, ym + dy, color);
+				shape_span(self, xm - xs, xm + xs, ym - dy, color);
 			}
 		}
 	}
-	
-	self->hold_display = false;
-	refresh_display(self,xm-rx,ym-ry,2*rx+1,2*ry+1);
+	for (int dx = 0; dx <= rx; dx++) {
+		uint32_t c = aa_chord(ry, rx, dx) + half;
+		int yi = c >> 8, a = c & 0xFF;
+
+		if (yi + out <= yb) {
+			break;		//rows done above
+		}
+		if (!filled && (yi > yb)) {
+			aa_plot4(self, xm, ym, dx, yi, color, 255 - a);
+		}
+		aa_plot4(self, xm, ym, dx, yi + out, color, a);
+	}
+
+	shape_end(self, xm - rx - 1, ym - ry - 1, 2 * rx + 3, 2 * ry + 3);
 }
 
-static mp_obj_t amoled_AMOLED_fill_ellipse(size_t n_args, const mp_obj_t *args) {
+static mp_obj_t amoled_AMOLED_aa_circle(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t r = mp_obj_get_int(args[3]);
+    uint16_t color = mp_obj_get_int(args[4]);
+
+    aa_ellipse(self, xm, ym, r, r, color, false);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_aa_circle_obj, 5, 5, amoled_AMOLED_aa_circle);
+
+
+static mp_obj_t amoled_AMOLED_aa_fill_circle(size_t n_args, const mp_obj_t *args) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    uint16_t xm = mp_obj_get_int(args[1]);
-    uint16_t ym = mp_obj_get_int(args[2]);
-    uint16_t rx = mp_obj_get_int(args[3]);
-	uint16_t ry = mp_obj_get_int(args[4]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t r = mp_obj_get_int(args[3]);
+    uint16_t color = mp_obj_get_int(args[4]);
+
+    aa_ellipse(self, xm, ym, r, r, color, true);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_aa_fill_circle_obj, 5, 5, amoled_AMOLED_aa_fill_circle);
+
+
+static mp_obj_t amoled_AMOLED_aa_ellipse(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t rx = mp_obj_get_int(args[3]);
+    mp_int_t ry = mp_obj_get_int(args[4]);
     uint16_t color = mp_obj_get_int(args[5]);
 
-    fill_ellipse(self, xm, ym, rx, ry, color);
+    aa_ellipse(self, xm, ym, rx, ry, color, false);
     return mp_const_none;
 }
 
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_fill_ellipse_obj, 6, 6, amoled_AMOLED_fill_ellipse);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_aa_ellipse_obj, 6, 6, amoled_AMOLED_aa_ellipse);
 
 
-// Return the center of a polygon as an (x, y) tuple
-static mp_obj_t amoled_AMOLED_polygon_center(size_t n_args, const mp_obj_t *args) {
-    size_t poly_len;
-    mp_obj_t *polygon;
-    mp_obj_get_array(args[1], &poly_len, &polygon);
-
-    mp_float_t sum = 0.0;
-    int vsx = 0;
-    int vsy = 0;
-
-    if (poly_len > 0) {
-        for (int idx = 0; idx < poly_len; idx++) {
-            size_t point_from_poly_len;
-            mp_obj_t *point_from_poly;
-            mp_obj_get_array(polygon[idx], &point_from_poly_len, &point_from_poly);
-            if (point_from_poly_len < 2) {
-                mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
-            }
+static mp_obj_t amoled_AMOLED_aa_fill_ellipse(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t rx = mp_obj_get_int(args[3]);
+    mp_int_t ry = mp_obj_get_int(args[4]);
+    uint16_t color = mp_obj_get_int(args[5]);
 
-            mp_int_t v1x = mp_obj_get_int(point_from_poly[0]);
-            mp_int_t v1y = mp_obj_get_int(point_from_poly[1]);
+    aa_ellipse(self, xm, ym, rx, ry, color, true);
+    return mp_const_none;
+}
 
-            mp_obj_get_array(polygon[(idx + 1) % poly_len], &point_from_poly_len, &point_from_poly);
-            if (point_from_poly_len < 2) {
-                mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
-            }
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_aa_fill_ellipse_obj, 6, 6, amoled_AMOLED_aa_fill_ellipse);
 
-            mp_int_t v2x = mp_obj_get_int(point_from_poly[0]);
-            mp_int_t v2y = mp_obj_get_int(point_from_poly[1]);
 
-            mp_float_t cross = v1x * v2y - v1y * v2x;
-            sum += cross;
-            vsx += (int)((v1x + v2x) * cross);
-            vsy += (int)((v1y + v2y) * cross);
-        }
+//Arcs, rings and pies are sectors of a ring filled by rows : on each row the ring gives up to two spans,
+//the sector up to two more from the side of the start and end rays they are on, with no trig per pixel.
+//Angles are in radians, clockwise (y down) from the x axis, the sector goes clockwise from start to end.
 
-        mp_float_t z = 1.0 / (3.0 * sum);
-        vsx = (int)(vsx * z);
-        vsy = (int)(vsy * z);
-    } else {
-        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
-    }
+//floor(n / d) for d > 0
+static int64_t floor_div(int64_t n, int64_t d) {
+	return (n >= 0) ? n / d : -((-n + d - 1) / d);
+}
 
-    mp_obj_t center[2] = {mp_obj_new_int(vsx), mp_obj_new_int(vsy)};
-    return mp_obj_new_tuple(2, center);
+//Interval [*lo, *hi] of row dy on the clockwise side of the ray (ax, ay), ax * dy - ay * x >= 0, within
+//[-lim, lim] (empty when lo > hi)
+static void sector_side(int32_t ax, int32_t ay, int dy, int lim, int *lo, int *hi) {
+	int64_t n = (int64_t)ax * dy;
+
+	*lo = -lim;
+	*hi = lim;
+	if (ay > 0) {
+		*hi = MAX(MIN(floor_div(n, ay), lim), -lim - 1);
+	} else if (ay < 0) {
+		*lo = MIN(MAX(-floor_div(n, -ay), -lim), lim + 1);
+	} else if (n < 0) {
+		*lo = lim + 1;
+	}
 }
 
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_polygon_center_obj, 2, 2, amoled_AMOLED_polygon_center);
+//Sector from start to end of the ring of pixels whose center is at r - t < d <= r from (xm, ym) (rounded
+//to the half pixel), the refreshed area is only the drawn part
+static void ring_sector(amoled_AMOLED_obj_t *self, int xm, int ym, int r, int t, mp_float_t start, mp_float_t end, uint16_t color) {
+	if ((r < 0) || (t <= 0)) {
+		return;
+	}
+	mp_float_t sweep = end - start;
+	bool full = (sweep >= 2 * MP_PI) || (sweep <= -2 * MP_PI);
+	if (sweep < 0) {
+		sweep += 2 * MP_PI;
+	}
+	bool wide = sweep > MP_PI;		//union of both sides instead of their intersection
+
+	//start ray, end ray turned back so the sector is on the clockwise side of both
+	int32_t sx = MICROPY_FLOAT_C_FUN(cos)(start) * 16384, sy = MICROPY_FLOAT_C_FUN(sin)(start) * 16384;
+	int32_t ex = -MICROPY_FLOAT_C_FUN(cos)(end) * 16384, ey = -MICROPY_FLOAT_C_FUN(sin)(end) * 16384;
+	if (!full && (ex == -sx) && (ey == -sy)) {
+		return;		//empty sector
+	}
+	color = shape_begin(self, color);
+
+	int64_t ro2 = (int64_t)r * r + r;
+	int64_t ri2 = (t > r) ? -1 : (int64_t)(r - t) * (r - t) + (r - t);
+	int xmin = INT_MAX, xmax = INT_MIN, ymin = INT_MAX, ymax = INT_MIN;
+
+	for (int dy = MAX(-r, -ym); dy <= MIN(r, self->height - 1 - ym); dy++) {
+		int64_t d2 = (int64_t)dy * dy;
+		int ring[4], sect[4], nr = 2, ns = 2;
+		int xo = isqrt64(ro2 - d2);
+
+		if (d2 > ri2) {
+			ring[0] = -xo;
+			ring[1] = xo;
+			nr = 1;
+		} else {		//hole in the middle
+			int xi = isqrt64(ri2 - d2) + 1;
+			ring[0] = -xo;
+			ring[1] = -xi;
+			ring[2] = xi;
+			ring[3] = xo;
+		}
+
+		if (full) {
+			sect[0] = -xo;
+			sect[1] = xo;
+			ns = 1;
+		} else {
+			sector_side(sx, sy, dy, xo, &sect[0], &sect[1]);
+			sector_side(ex, ey, dy, xo, &sect[2], &sect[3]);
+			if (!wide) {
+				sect[0] = MAX(sect[0], sect[2]);
+				sect[1] = MIN(sect[1], sect[3]);
+				ns = 1;
+			} else if ((sect[0] <= sect[3] + 1) && (sect[2] <= sect[1] + 1)) {	//overlapping sides
+				sect[0] = MIN(sect[0], sect[2]);
+				sect[1] = MAX(sect[1], sect[3]);
+				ns = 1;
+			}
+		}
+
+		for (int i = 0; i < nr; i++) {
+			for (int j = 0; j < ns; j++) {
+				int lo = MAX(ring[2 * i], sect[2 * j]);
+				int hi = MIN(ring[2 * i + 1], sect[2 * j + 1]);
+				if (lo > hi) {
+					continue;
+				}
+				shape_span(self, xm + lo, xm + hi, ym + dy, color);
+				xmin = MIN(xmin, xm + lo);
+				xmax = MAX(xmax, xm + hi);
+				ymin = MIN(ymin, ym + dy);
+				ymax = MAX(ymax, ym + dy);
+			}
+		}
+	}
+
+	if (xmin <= xmax) {
+		shape_end(self, xmin, ymin, xmax - xmin + 1, ymax - ymin + 1);
+	}
+}
+
+//	arc(x, y, r, start, end, color) : one pixel wide arc of radius r
+static mp_obj_t amoled_AMOLED_arc(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t r = mp_obj_get_int(args[3]);
+    mp_float_t start = mp_obj_get_float(args[4]);
+    mp_float_t end = mp_obj_get_float(args[5]);
+    uint16_t color = mp_obj_get_int(args[6]);
+
+    ring_sector(self, xm, ym, r, 1, start, end, color);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_arc_obj, 7, 7, amoled_AMOLED_arc);
+
+
+//	fill_arc(x, y, r, width, start, end, color) : ring sector width pixels wide inside radius r
+static mp_obj_t amoled_AMOLED_fill_arc(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t r = mp_obj_get_int(args[3]);
+    mp_int_t width = mp_obj_get_int(args[4]);
+    mp_float_t start = mp_obj_get_float(args[5]);
+    mp_float_t end = mp_obj_get_float(args[6]);
+    uint16_t color = mp_obj_get_int(args[7]);
+
+    ring_sector(self, xm, ym, r, width, start, end, color);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_fill_arc_obj, 8, 8, amoled_AMOLED_fill_arc);
+
+
+//	pie(x, y, r, start, end, color) : filled circle sector
+static mp_obj_t amoled_AMOLED_pie(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t xm = mp_obj_get_int(args[1]);
+    mp_int_t ym = mp_obj_get_int(args[2]);
+    mp_int_t r = mp_obj_get_int(args[3]);
+    mp_float_t start = mp_obj_get_float(args[4]);
+    mp_float_t end = mp_obj_get_float(args[5]);
+    uint16_t color = mp_obj_get_int(args[6]);
+
+    ring_sector(self, xm, ym, r, r + 1, start, end, color);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_pie_obj, 7, 7, amoled_AMOLED_pie);
 
 
 static void rotate_polygon(Polygon *polygon, Point center, mp_float_t angle) {
@@ -1575,12 +2986,148 @@ static void rotate_polygon(Polygon *polygon, Point center, mp_float_t angle) {
 }
 
 
-static mp_obj_t amoled_AMOLED_polygon(size_t n_args, const mp_obj_t *args) {
-    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+//Read a list of (x, y) points
+static void polygon_parse(mp_obj_t *polygon, size_t poly_len, Point *point) {
+	for (size_t idx = 0; idx < poly_len; idx++) {
+		size_t point_from_poly_len;
+		mp_obj_t *point_from_poly;
+		mp_obj_get_array(polygon[idx], &point_from_poly_len, &point_from_poly);
+		if (point_from_poly_len < 2) {
+			mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
+		}
+		point[idx].x = mp_obj_get_int(point_from_poly[0]);
+		point[idx].y = mp_obj_get_int(point_from_poly[1]);
+	}
+}
+
+//Center of gravity of a polygon
+static void polygon_centroid(const Point *point, size_t poly_len, mp_int_t *cx, mp_int_t *cy) {
+	mp_float_t sum = 0.0, vsx = 0.0, vsy = 0.0;
+
+	for (size_t idx = 0; idx < poly_len; idx++) {
+		const Point *v1 = &point[idx];
+		const Point *v2 = &point[(idx + 1) % poly_len];
+		mp_float_t cross = v1->x * v2->y - v1->y * v2->x;
+		sum += cross;
+		vsx += (v1->x + v2->x) * cross;
+		vsy += (v1->y + v2->y) * cross;
+	}
+	if (sum == 0) {
+		mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
+	}
+	*cx = (mp_int_t)(vsx / (3 * sum));
+	*cy = (mp_int_t)(vsy / (3 * sum));
+}
+
+//Create a polygon : Polygon(points), points is a list of (x, y)
+mp_obj_t amoled_Polygon_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args) {
+	mp_arg_check_num(n_args, n_kw, 1, 1, false);
+
+	size_t poly_len;
+	mp_obj_t *polygon;
+	mp_obj_get_array(all_args[0], &poly_len, &polygon);
+	if (poly_len == 0) {
+		mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
+	}
+
+	amoled_polygon_obj_t *self = m_new_obj(amoled_polygon_obj_t);
+	self->base.type = &amoled_Polygon_type;
+	self->length = poly_len;
+	self->points = m_new(Point, 2 * poly_len);
+	self->rotated = &self->points[poly_len];
+	self->angle = 0;
+	self->center = (Point) { 0, 0 };
+	self->edges = NULL;		//edge table, allocated by the first fill
+	self->edges_size = 0;
+	polygon_parse(polygon, poly_len, self->points);
+	return MP_OBJ_FROM_PTR(self);
+}
+
+static void amoled_Polygon_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t  kind) {
+    (void) kind;
+    amoled_polygon_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "<AMOLED Polygon - Points=%u>", (unsigned int)self->length);
+}
+
+//Points rotated by angle around center, only computed again when angle or center changed
+static const Point *polygon_rotated(amoled_polygon_obj_t *self, mp_float_t angle, Point center) {
+	if (angle == 0) {
+		return self->points;
+	}
+	if ((angle != self->angle) || (center.x != self->center.x) || (center.y != self->center.y)) {
+		memcpy(self->rotated, self->points, self->length * sizeof(Point));
+		Polygon polygon = { self->length, self->rotated };
+		rotate_polygon(&polygon, center, angle);
+		self->angle = angle;
+		self->center = center;
+	}
+	return self->rotated;
+}
+
+//Points of a Polygon or of a list of (x, y), rotated when angle is not 0.
+//A list is read into a GC buffer, given back by polygon_points_free() (or collected if drawing raises).
+static const Point *polygon_points(amoled_AMOLED_obj_t *self, mp_obj_t poly_in, mp_float_t angle, Point center, size_t *poly_len) {
+	if (mp_obj_is_type(poly_in, &amoled_Polygon_type)) {
+		amoled_polygon_obj_t *poly = MP_OBJ_TO_PTR(poly_in);
+		*poly_len = poly->length;
+		return polygon_rotated(poly, angle, center);
+	}
+
+	mp_obj_t *polygon;
+	mp_obj_get_array(poly_in, poly_len, &polygon);
+	if (*poly_len == 0) {
+		mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
+	}
+	Point *point = m_new(Point, *poly_len);
+	polygon_parse(polygon, *poly_len, point);
+	if (angle != 0) {
+		Polygon rotated = { *poly_len, point };
+		rotate_polygon(&rotated, center, angle);
+	}
+	return point;
+}
+
+static void polygon_points_free(mp_obj_t poly_in, const Point *point, size_t poly_len) {
+	if (!mp_obj_is_type(poly_in, &amoled_Polygon_type)) {
+		m_del(Point, (Point *)point, poly_len);
+	}
+}
+
+//	center() : center of gravity of the polygon as an (x, y) tuple
+static mp_obj_t amoled_Polygon_center(mp_obj_t self_in) {
+	amoled_polygon_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	mp_int_t cx, cy;
 
+	polygon_centroid(self->points, self->length, &cx, &cy);
+	mp_obj_t center[2] = {mp_obj_new_int(cx), mp_obj_new_int(cy)};
+	return mp_obj_new_tuple(2, center);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_Polygon_center_obj, amoled_Polygon_center);
+
+
+// Return the center of a polygon (list of (x, y) or Polygon) as an (x, y) tuple
+static mp_obj_t amoled_AMOLED_polygon_center(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
     size_t poly_len;
-    mp_obj_t *polygon;
-    mp_obj_get_array(args[1], &poly_len, &polygon);
+    mp_int_t cx, cy;
+
+    if (mp_obj_is_type(args[1], &amoled_Polygon_type)) {
+        return amoled_Polygon_center(args[1]);
+    }
+    const Point *point = polygon_points(self, args[1], 0, (Point) { 0, 0 }, &poly_len);
+    polygon_centroid(point, poly_len, &cx, &cy);
+    polygon_points_free(args[1], point, poly_len);
+
+    mp_obj_t center[2] = {mp_obj_new_int(cx), mp_obj_new_int(cy)};
+    return mp_obj_new_tuple(2, center);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_polygon_center_obj, 2, 2, amoled_AMOLED_polygon_center);
+
+
+//Draw the outline of a polygon, points are relative to x, y
+static void polygon_draw(amoled_AMOLED_obj_t *self, const Point *point, int poly_len, mp_int_t x, mp_int_t y, uint16_t color) {
 	uint16_t xmax;
 	uint16_t xmin;
 	uint16_t ymin;
@@ -1589,253 +3136,505 @@ static mp_obj_t amoled_AMOLED_polygon(size_t n_args, const mp_obj_t *args) {
 	uint16_t y0;
 	uint16_t x1;
 	uint16_t y1;
+
+	xmax = (int)point[0].x + x;
+	xmin = xmax;
+	ymax = (int)point[0].y + y;
+	ymin = ymax;
 	
-    self->work = NULL;
+	self->hold_display = true;
 
-    if (poly_len > 0) {
-        mp_int_t x = mp_obj_get_int(args[2]);
-        mp_int_t y = mp_obj_get_int(args[3]);
-        mp_int_t color = mp_obj_get_int(args[4]);
+    for (int idx = 1; idx < poly_len; idx++) {
+		x0 = (int)point[idx - 1].x + x;
+		y0 = (int)point[idx - 1].y + y;
+		x1 = (int)point[idx].x + x;
+		y1 = (int)point[idx].y + y;
+		
+		xmax = (x0>xmax) ? x0 : xmax;
+		xmin = (x0<xmin) ? x0 : xmin;
+		ymax = (y0>ymax) ? y0 : ymax;
+		ymin = (y0<ymin) ? y0 : ymin;
+		
+        line(self,x0,y0,x1,y1, color);
+    }
+	
+	self->hold_display = false;
+	refresh_display(self,xmin,ymin,xmax-xmin,ymax-ymin);
+}
 
-        mp_float_t angle = 0.0f;
-        if (n_args > 5 && mp_obj_is_float(args[5])) {
-            angle = mp_obj_float_get(args[5]);
-        }
+//	polygon(points, x, y, color[, angle, cx, cy]) : points is a Polygon or a list of (x, y)
+static mp_obj_t amoled_AMOLED_polygon(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t x = mp_obj_get_int(args[2]);
+    mp_int_t y = mp_obj_get_int(args[3]);
+    mp_int_t color = mp_obj_get_int(args[4]);
 
-        mp_int_t cx = 0;
-        mp_int_t cy = 0;
+    mp_float_t angle = 0.0f;
+    if (n_args > 5 && mp_obj_is_float(args[5])) {
+        angle = mp_obj_float_get(args[5]);
+    }
+    if (angle < 0) {	// polygon() only turns one way
+        angle = 0;
+    }
 
-        if (n_args > 6) {
-            cx = mp_obj_get_int(args[6]);
-            cy = mp_obj_get_int(args[7]);
-        }
+    Point center = {0, 0};
+    if (n_args > 6) {
+        center.x = mp_obj_get_int(args[6]);
+        center.y = mp_obj_get_int(args[7]);
+    }
 
-        self->work = (void *) heap_caps_aligned_calloc(RAM_ALIGNMENT, poly_len, sizeof(Point), MALLOC_CAP_8BIT);
-        if (self->work) {
-            Point *point = (Point *)self->work;
+    size_t poly_len;
+    const Point *point = polygon_points(self, args[1], angle, center, &poly_len);
+    polygon_draw(self, point, poly_len, x, y, color);
+    polygon_points_free(args[1], point, poly_len);
+    return mp_const_none;
+}
 
-            for (int idx = 0; idx < poly_len; idx++) {
-                size_t point_from_poly_len;
-                mp_obj_t *point_from_poly;
-                mp_obj_get_array(polygon[idx], &point_from_poly_len, &point_from_poly);
-                if (point_from_poly_len < 2) {
-                    mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
-                }
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_polygon_obj, 5, 8, amoled_AMOLED_polygon);
 
-                mp_int_t px = mp_obj_get_int(point_from_poly[0]);
-                mp_int_t py = mp_obj_get_int(point_from_poly[1]);
-                point[idx].x = px;
-                point[idx].y = py;
-            }
 
-            Point center;
-            center.x = cx;
-            center.y = cy;
+//Fill a polygon with an active edge list : edges are sorted by first row once, then on each row the
+//edges crossing it are kept sorted by x (insertion sort, they hardly move from a row to the next)
+//and the spans inside the polygon are filled. Rows are sampled at integer y, x in 16.16 fixed point.
+//With aa, points are pixel centers and each row is sampled on AA_SUB rows, the coverage of every pixel
+//is summed (partial pixels from the x fraction, whole ones in a running delta) then blended.
+//The edge table is kept in cache (a Polygon object) when given, only grown, else it is a temporary buffer.
+static void fill_polygon(amoled_AMOLED_obj_t *self, Polygon *polygon, Point location, uint16_t color, uint8_t rule, bool aa, amoled_polygon_obj_t *cache) {
+	int n = 0, i, j;
+	int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
+	int sub = aa ? AA_SUB : 1;
+	mp_float_t shift = aa ? 0.5f : 0.0f;	//pixel x covers [x - 0.5, x + 0.5[ in aa
 
-            Polygon polygon;
-            polygon.length = poly_len;
-            polygon.points = self->work;
+	if (polygon->length < 3) {
+		return;
+	}
+	if ((self->fram_buf == NULL) && (self->band_ops == NULL)) {
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("No framebuffer available."));
+	}
+	size_t size = polygon->length * (sizeof(amoled_edge_t) + sizeof(amoled_edge_t *));
+	if (aa) {
+		size += 2 * (self->width + 1) * sizeof(int32_t);
+	}
+	amoled_edge_t *edges;
+	if (cache) {
+		if (cache->edges_size < size) {
+			cache->edges = m_renew(uint8_t, cache->edges, cache->edges_size, size);
+			cache->edges_size = size;
+		}
+		edges = (amoled_edge_t *)cache->edges;
+	} else {
+		edges = (amoled_edge_t *)m_new(uint8_t, size);	//GC buffer, collected if a span raises (band list full)
+	}
+	amoled_edge_t **active = (amoled_edge_t **)&edges[polygon->length];
+	int32_t *cover = (int32_t *)&active[polygon->length];		//aa : partial pixels coverage
+	int32_t *delta = cover + self->width + 1;					//aa : whole pixels coverage changes
+	if (aa) {
+		memset(cover, 0, 2 * (self->width + 1) * sizeof(int32_t));
+	}
 
-            if (angle > 0) {
-                rotate_polygon(&polygon, center, angle);
-            }
+	//Edge table, a row y is inside an edge when y_top < y <= y_bottom (horizontal edges cross none)
+	//in aa, sub row j samples y = (j + 0.5) / sub
+	j = polygon->length - 1;
+	for (i = 0; i < polygon->length; j = i++) {
+		mp_float_t xi = polygon->points[i].x + location.x + shift, yi = polygon->points[i].y + location.y + shift;
+		mp_float_t xj = polygon->points[j].x + location.x + shift, yj = polygon->points[j].y + location.y + shift;
+
+		minX = MIN(minX, (int)floorf(xi));
+		maxX = MAX(maxX, (int)floorf(xi));
+		minY = MIN(minY, (int)floorf(yi));
+		maxY = MAX(maxY, (int)floorf(yi));
+		yi = yi * sub - shift;
+		yj = yj * sub - shift;
+		if (yi == yj) {
+			continue;
+		}
+		int dir = (yi > yj) ? 1 : -1;
+		if (dir < 0) {	//go down from (xi, yi)
+			mp_float_t t = xi; xi = xj; xj = t;
+			t = yi; yi = yj; yj = t;
+		}
+		amoled_edge_t *e = &edges[n];
+		e->y0 = (int)floorf(yj) + 1;
+		e->y1 = (int)floorf(yi);
+		if (e->y0 > e->y1) {
+			continue;
+		}
+		mp_float_t slope = (xi - xj) / (yi - yj);
+		e->dx = (int32_t)(slope * 65536);
+		e->x = (int32_t)((xj + (e->y0 - yj) * slope) * 65536);
+		e->dir = dir;
 
-			xmax = (int)point[0].x + x;
-			xmin = xmax;
-			ymax = (int)point[0].y + y;
-			ymin = ymax;
-			
-			self->hold_display = true;
+		for (int k = n++; (k > 0) && (edges[k - 1].y0 > edges[k].y0); k--) {	//sorted by first row
+			amoled_edge_t t = edges[k]; edges[k] = edges[k - 1]; edges[k - 1] = t;
+		}
+	}
 
-            for (int idx = 1; idx < poly_len; idx++) {
-				x0 = (int)point[idx - 1].x + x;
-				y0 = (int)point[idx - 1].y + y;
-				x1 = (int)point[idx].x + x;
-				y1 = (int)point[idx].y + y;
-				
-				xmax = (x0>xmax) ? x0 : xmax;
-				xmin = (x0<xmin) ? x0 : xmin;
-				ymax = (y0>ymax) ? y0 : ymax;
-				ymin = (y0<ymin) ? y0 : ymin;
-				
-                line(self,x0,y0,x1,y1, color);
-            }
-			
-			self->hold_display = false;
-			refresh_display(self,xmin,ymin,xmax-xmin,ymax-ymin);
-			
-            heap_caps_free(self->work);
-            self->work = NULL;
-        } else {
-            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
-        }
-    } else {
-        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
+	color = fb_color(self, color);
+	int next = 0, count = 0;
+	int y = (n) ? MAX(edges[0].y0, 0) : 0;
+	int y_end = MIN(maxY, self->height - 1) * sub + sub - 1;
+	int32_t x_end = self->width << 8;		//aa : 24.8 x of the right side of the display
+
+	if (aa) {
+		y -= y % sub;	//start on the first sub row of a pixel row
+	}
+	for (; (y <= y_end) && ((next < n) || count || (aa && (y % sub))); y++) {
+		//drop finished edges, step the others
+		j = 0;
+		for (i = 0; i < count; i++) {
+			if (active[i]->y1 >= y) {
+				active[i]->x += active[i]->dx;
+				active[j++] = active[i];
+			}
+		}
+		count = j;
+
+		//add the edges starting on this row (or above the display)
+		for (; (next < n) && (edges[next].y0 <= y); next++) {
+			amoled_edge_t *e = &edges[next];
+			if (e->y1 < y) {
+				continue;
+			}
+			e->x += (int32_t)((int64_t)e->dx * (y - e->y0));
+			active[count++] = e;
+		}
+
+		for (i = 1; i < count; i++) {
+			amoled_edge_t *e = active[i];
+			for (j = i; (j > 0) && (active[j - 1]->x > e->x); j--) {
+				active[j] = active[j - 1];
+			}
+			active[j] = e;
+		}
+
+		//spans between crossings, inside when odd (even-odd) or not zero (non zero)
+		int winding = 0;
+		for (i = 0; i < count - 1; i++) {
+			winding = (rule == FILL_NON_ZERO) ? winding + active[i]->dir : winding ^ 1;
+			if (!winding) {
+				continue;
+			}
+			if (!aa) {
+				int x0 = MAX(active[i]->x >> 16, 0);
+				int x1 = MIN(active[i + 1]->x >> 16, self->width - 1);
+				if (x0 <= x1) {
+					line_run(self, x0, y, x1 - x0 + 1, 1, color);
+				}
+				continue;
+			}
+			//coverage of the sub row span, 256 / AA_SUB for a whole pixel
+			int32_t xa = MAX(active[i]->x >> 8, 0);
+			int32_t xb = MIN(active[i + 1]->x >> 8, x_end);
+			if (xa >= xb) {
+				continue;
+			}
+			int pa = xa >> 8, pb = xb >> 8;
+			if (pa == pb) {
+				cover[pa] += (xb - xa) / AA_SUB;
+			} else {
+				cover[pa] += (256 - (xa & 0xFF)) / AA_SUB;
+				delta[pa + 1] += 256 / AA_SUB;
+				delta[pb] -= 256 / AA_SUB;
+				cover[pb] += (xb & 0xFF) / AA_SUB;
+			}
+		}
+
+		//aa : last sub row of a pixel row, blend it
+		if (aa && ((y % sub) == sub - 1)) {
+			int row = y / sub, run = 0, start = -1;
+			for (int x = 0; x <= self->width; x++) {
+				run += delta[x];
+				int32_t c = (x < self->width) ? cover[x] + run : 0;
+				cover[x] = 0;
+				delta[x] = 0;
+				if (c >= 255) {		//whole pixels are filled by spans
+					if (start < 0) {
+						start = x;
+					}
+					continue;
+				}
+				if (start >= 0) {
+					line_run(self, start, row, x - start, 1, color);
+					start = -1;
+				}
+				if (c > 0) {
+					aa_plot(self, x, row, color, c);
+				}
+			}
+		}
+	}
+	if (!cache) {
+		m_del(uint8_t, edges, size);
+	}
+
+	if (!self->hold_display) {
+		refresh_display(self, minX - aa, minY - aa, maxX - minX + 1 + 2 * aa, maxY - minY + 1 + 2 * aa);
+	}
+}
+
+//Arguments of fill_polygon() and aa_fill_polygon()
+static mp_obj_t fill_polygon_args(size_t n_args, const mp_obj_t *args, bool aa) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t x = mp_obj_get_int(args[2]);
+    mp_int_t y = mp_obj_get_int(args[3]);
+    mp_int_t color = mp_obj_get_int(args[4]);
+
+    mp_float_t angle = 0.0f;
+    if (n_args > 5) {
+        angle = mp_obj_get_float(args[5]);
+    }
+
+    Point center = {0, 0};
+    if (n_args > 6) {
+        center.x = mp_obj_get_int(args[6]);
+        center.y = mp_obj_get_int(args[7]);
+    }
+
+    mp_int_t rule = (n_args > 8) ? mp_obj_get_int(args[8]) : FILL_EVEN_ODD;
+    if ((rule != FILL_EVEN_ODD) && (rule != FILL_NON_ZERO)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("rule must be EVEN_ODD or NON_ZERO"));
     }
 
+    size_t poly_len;
+    const Point *point = polygon_points(self, args[1], angle, center, &poly_len);
+    Polygon polygon = {poly_len, (Point *)point};
+    Point location = {x, y};
+    amoled_polygon_obj_t *cache = mp_obj_is_type(args[1], &amoled_Polygon_type) ? MP_OBJ_TO_PTR(args[1]) : NULL;
+    fill_polygon(self, &polygon, location, color, rule, aa, cache);
+    polygon_points_free(args[1], point, poly_len);
     return mp_const_none;
 }
 
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_polygon_obj, 5, 8, amoled_AMOLED_polygon);
+//	fill_polygon(points, x, y, color[, angle, cx, cy, rule]) : points is a Polygon or a list of (x, y)
+static mp_obj_t amoled_AMOLED_fill_polygon(size_t n_args, const mp_obj_t *args) {
+    return fill_polygon_args(n_args, args, false);
+}
 
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_fill_polygon_obj, 5, 9, amoled_AMOLED_fill_polygon);
 
-// public-domain code by Darel Rex Finley, 2007 https://alienryderflex.com/polygon_fill/ 
-static void fill_polygon(amoled_AMOLED_obj_t *self, Polygon *polygon, Point location, uint16_t color) {
-    int nodes, nodeX[MAX_POLY_CORNERS], pixelY, i, j, swap;
 
-    int minX = INT_MAX;
-    int maxX = INT_MIN;
-    int minY = INT_MAX;
-    int maxY = INT_MIN;
+//	aa_fill_polygon(points, x, y, color[, angle, cx, cy, rule]) : fill_polygon() with anti-aliased edges
+static mp_obj_t amoled_AMOLED_aa_fill_polygon(size_t n_args, const mp_obj_t *args) {
+    return fill_polygon_args(n_args, args, true);
+}
 
-    for (i = 0; i < polygon->length; i++) {
-        if (polygon->points[i].x < minX) {
-            minX = (int)polygon->points[i].x;
-        }
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_aa_fill_polygon_obj, 5, 9, amoled_AMOLED_aa_fill_polygon);
 
-        if (polygon->points[i].x > maxX) {
-            maxX = (int)polygon->points[i].x;
-        }
 
-        if (polygon->points[i].y < minY) {
-            minY = (int)polygon->points[i].y;
-        }
+//Thick line filled as an anti-aliased polygon : a rectangle along the line, its ends stretched by half
+//the width for square caps or turned into half circles for round caps
+static void thick_line(amoled_AMOLED_obj_t *self, int x0, int y0, int x1, int y1, int width, uint16_t color, uint8_t cap) {
+	Point points[2 * (CAP_SEGMENTS + 1)];
+	Polygon polygon = { 0, points };
 
-        if (polygon->points[i].y > maxY) {
-            maxY = (int)polygon->points[i].y;
-        }
-    }
+	if (width <= 0) {
+		return;
+	}
+	mp_float_t dx = x1 - x0, dy = y1 - y0, len = MICROPY_FLOAT_C_FUN(sqrt)(dx * dx + dy * dy);
+	if (len == 0) {		//a dot, oriented along x
+		dx = 1;
+		len = 1;
+	}
+	mp_float_t ux = dx * width / (2 * len), uy = dy * width / (2 * len);	//half width along the line
+	int segs = (cap == CAP_ROUND) ? MAX(2, MIN(width, CAP_SEGMENTS)) : 1;
+
+	for (int k = 0; k <= segs; k++) {	//end from its left to its right side, then the start
+		mp_float_t c = 1, s = 0;
+		if (cap == CAP_ROUND) {
+			c = MICROPY_FLOAT_C_FUN(cos)(k * MP_PI / segs);
+			s = MICROPY_FLOAT_C_FUN(sin)(k * MP_PI / segs);
+		} else {
+			c = k ? -1 : 1;
+			s = (cap == CAP_SQUARE) ? 1 : 0;
+		}
+		points[k] = (Point) { x1 - uy * c + ux * s, y1 + ux * c + uy * s };
+		points[segs + 1 + k] = (Point) { x0 + uy * c - ux * s, y0 - ux * c - uy * s };
+	}
+	polygon.length = 2 * (segs + 1);
+	fill_polygon(self, &polygon, (Point) { 0, 0 }, color, FILL_NON_ZERO, true, NULL);
+}
 
-	self->hold_display = true;
-    //  Loop through the rows
-    for (pixelY = minY; pixelY < maxY; pixelY++) {
-        //  Build a list of nodes.
-        nodes = 0;
-        j = polygon->length - 1;
-        for (i = 0; i < polygon->length; i++) {
-            if ((polygon->points[i].y < pixelY && polygon->points[j].y >= pixelY) ||
-                (polygon->points[j].y < pixelY && polygon->points[i].y >= pixelY)) {
-                if (nodes < MAX_POLY_CORNERS) {
-                    nodeX[nodes++] = (int)(polygon->points[i].x +
-                        (pixelY - polygon->points[i].y) /
-                        (polygon->points[j].y - polygon->points[i].y) *
-                        (polygon->points[j].x - polygon->points[i].x));
-                } else {
-                    mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon too complex increase MAX_POLY_CORNERS."));
-                }
-            }
-            j = i;
-        }
+//	thick_line(x0, y0, x1, y1, width, color[, cap]) : cap is CAP_BUTT (default), CAP_SQUARE or CAP_ROUND
+static mp_obj_t amoled_AMOLED_thick_line(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t x0 = mp_obj_get_int(args[1]);
+    mp_int_t y0 = mp_obj_get_int(args[2]);
+    mp_int_t x1 = mp_obj_get_int(args[3]);
+    mp_int_t y1 = mp_obj_get_int(args[4]);
+    mp_int_t width = mp_obj_get_int(args[5]);
+    uint16_t color = mp_obj_get_int(args[6]);
+    uint8_t cap = (n_args > 7) ? mp_obj_get_int(args[7]) : CAP_BUTT;
+
+    thick_line(self, x0, y0, x1, y1, width, color, cap);
+    return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_thick_line_obj, 7, 8, amoled_AMOLED_thick_line);
+
+
+/*-----------------------------------------------------------------------------------------------------
+Below are batch drawing functions : many primitives from packed int16 arrays in one call
+------------------------------------------------------------------------------------------------------*/
+
+
+//Get an int16 array of records of fields values (array.array('h'), bytes, bytearray...), returns the record count
+static size_t batch_buffer(mp_obj_t buf_in, uint8_t fields, const int16_t **data) {
+	mp_buffer_info_t bufinfo;
+	mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+	if (bufinfo.len % (fields * sizeof(int16_t))) {
+		mp_raise_ValueError(MP_ERROR_TEXT("buffer length must be a multiple of the record size"));
+	}
+	if ((uintptr_t)bufinfo.buf & 1) {		//a sliced memoryview can start on an odd byte, int16 loads fault on Xtensa
+		mp_raise_ValueError(MP_ERROR_TEXT("buffer must be 2 bytes aligned"));
+	}
+	*data = bufinfo.buf;
+	return bufinfo.len / (fields * sizeof(int16_t));
+}
+
+//Clip a rectangle to the display, false when nothing is left
+static bool batch_clip(amoled_AMOLED_obj_t *self, int *x, int *y, int *w, int *h) {
+	if (*x < 0) { *w += *x; *x = 0; }
+	if (*y < 0) { *h += *y; *y = 0; }
+	if (*x + *w > self->width)  *w = self->width - *x;
+	if (*y + *h > self->height) *h = self->height - *y;
+	return (*w > 0) && (*h > 0);
+}
+
+static void batch_pixels(amoled_AMOLED_obj_t *self, const amoled_batch_t *batch) {
+	const int16_t *xy = batch->rec;
+
+	for (size_t i = 0; i < batch->count; i++, xy += 2) {
+		if (((uint16_t)xy[0] < self->width) && ((uint16_t)xy[1] < self->height)) {
+			fb_put(self, xy[1] * self->width + xy[0], batch->colors ? fb_color(self, batch->colors[i]) : batch->color);
+			if (!self->hold_display && self->auto_refresh) {
+				refresh_display(self, xy[0], xy[1], 1, 1);
+			}
+		}
+	}
+}
+
+//	pixels(coords, color|colors) : coords holds x, y pairs, colors one color per pair
+static mp_obj_t amoled_AMOLED_pixels(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	const int16_t *xy;
+	size_t count = batch_buffer(args[1], 2, &xy);
+	const uint16_t *colors = NULL;
+	uint16_t color = 0;
+
+	if (mp_obj_is_int(args[2])) {
+		color = fb_color(self, mp_obj_get_int(args[2]));
+	} else {
+		mp_buffer_info_t bufinfo;
+		mp_get_buffer_raise(args[2], &bufinfo, MP_BUFFER_READ);
+		if (bufinfo.len < count * sizeof(uint16_t)) {
+			mp_raise_ValueError(MP_ERROR_TEXT("not enough colors"));
+		}
+		if ((uintptr_t)bufinfo.buf & 1) {
+			mp_raise_ValueError(MP_ERROR_TEXT("buffer must be 2 bytes aligned"));
+		}
+		colors = bufinfo.buf;
+	}
+	if ((self->fram_buf == NULL) && (self->band_ops == NULL)) {
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("No framebuffer available."));
+	}
+
+	amoled_batch_t batch = { .rec = xy, .count = count, .colors = colors, .color = color };
+	refresh_batch(self, batch_pixels, &batch);
+	return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_pixels_obj, 3, 3, amoled_AMOLED_pixels);
 
-        //  Sort the nodes, via a simple “Bubble” sort.
-        i = 0;
-        while (i < nodes - 1) {
-            if (nodeX[i] > nodeX[i + 1]) {
-                swap = nodeX[i];
-                nodeX[i] = nodeX[i + 1];
-                nodeX[i + 1] = swap;
-                if (i) {
-                    i--;
-                }
-            } else {
-                i++;
-            }
-        }		
-        //  Fill the pixels between node pairs.
-        for (i = 0; i < nodes; i += 2) {
-            if (nodeX[i] >= maxX) {
-                break;
-            }
 
-            if (nodeX[i + 1] > minX) {
-                if (nodeX[i] < minX) {
-                    nodeX[i] = minX;
-                }
+//Fill records of (x, y, w, h, color), h is 1 when not in the record
+static void batch_fill(amoled_AMOLED_obj_t *self, const amoled_batch_t *batch) {
+	const int16_t *rec = batch->rec;
+	uint8_t fields = batch->fields;
 
-                if (nodeX[i + 1] > maxX) {
-                    nodeX[i + 1] = maxX;
-                }
+	for (size_t i = 0; i < batch->count; i++, rec += fields) {
+		int x = rec[0], y = rec[1], w = rec[2];
+		int h = (fields == 5) ? rec[3] : 1;
+		if (batch_clip(self, &x, &y, &w, &h)) {
+			fill_frame_buffer(self, (uint16_t)rec[fields - 1], x, y, w, h);
+		}
+	}
+}
 
-                fast_hline(self, (int)location.x + nodeX[i], (int)location.y + pixelY, nodeX[i + 1] - nodeX[i] + 1, color);
-            }
-        }
-    }
-	/*Adjust display refresh*/
-	minX = minX + (int)location.x;
-    maxX = maxX + (int)location.x;
-    minY = minY + (int)location.y;
-    maxY = maxY + (int)location.y;
-	self->hold_display = false;	
-	refresh_display(self,minX,minY,maxX - minX,maxY - minY);
+//	hlines(buf) : buf holds x, y, w, color records
+static mp_obj_t amoled_AMOLED_hlines(mp_obj_t self_in, mp_obj_t buf_in) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	const int16_t *rec;
+	size_t count = batch_buffer(buf_in, 4, &rec);
+	amoled_batch_t batch = { .rec = rec, .count = count, .fields = 4 };
+
+	refresh_batch(self, batch_fill, &batch);
+	return mp_const_none;
 }
 
-static mp_obj_t amoled_AMOLED_fill_polygon(size_t n_args, const mp_obj_t *args) {
-    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+static MP_DEFINE_CONST_FUN_OBJ_2(amoled_AMOLED_hlines_obj, amoled_AMOLED_hlines);
 
-    size_t poly_len;
-    mp_obj_t *polygon;
-    mp_obj_get_array(args[1], &poly_len, &polygon);
 
-    self->work = NULL;
+//	fill_rects(buf) : buf holds x, y, w, h, color records
+static mp_obj_t amoled_AMOLED_fill_rects(mp_obj_t self_in, mp_obj_t buf_in) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	const int16_t *rec;
+	size_t count = batch_buffer(buf_in, 5, &rec);
+	amoled_batch_t batch = { .rec = rec, .count = count, .fields = 5 };
 
-    if (poly_len > 0) {
-        mp_int_t x = mp_obj_get_int(args[2]);
-        mp_int_t y = mp_obj_get_int(args[3]);
-        mp_int_t color = mp_obj_get_int(args[4]);
+	refresh_batch(self, batch_fill, &batch);
+	return mp_const_none;
+}
 
-        mp_float_t angle = 0.0f;
-        if (n_args > 5) {
-            angle = mp_obj_float_get(args[5]);
-        }
+static MP_DEFINE_CONST_FUN_OBJ_2(amoled_AMOLED_fill_rects_obj, amoled_AMOLED_fill_rects);
 
-        mp_int_t cx = 0;
-        mp_int_t cy = 0;
 
-        if (n_args > 6) {
-            cx = mp_obj_get_int(args[6]);
-            cy = mp_obj_get_int(args[7]);
-        }
+static void batch_lines(amoled_AMOLED_obj_t *self, const amoled_batch_t *batch) {
+	const int16_t *rec = batch->rec;
 
-        self->work = (void *) heap_caps_aligned_calloc(RAM_ALIGNMENT, poly_len, sizeof(Point), MALLOC_CAP_8BIT);
-        if (self->work) {
-            Point *point = (Point *)self->work;
+	for (size_t i = 0; i < batch->count; i++, rec += 4) {
+		line(self, rec[0], rec[1], rec[2], rec[3], batch->color);
+	}
+}
 
-            for (int idx = 0; idx < poly_len; idx++) {
-                size_t point_from_poly_len;
-                mp_obj_t *point_from_poly;
-                mp_obj_get_array(polygon[idx], &point_from_poly_len, &point_from_poly);
-                if (point_from_poly_len < 2) {
-                    mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
-                }
+//	lines(buf, color) : buf holds x0, y0, x1, y1 records
+static mp_obj_t amoled_AMOLED_lines(mp_obj_t self_in, mp_obj_t buf_in, mp_obj_t color_in) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	const int16_t *rec;
+	size_t count = batch_buffer(buf_in, 4, &rec);
+	amoled_batch_t batch = { .rec = rec, .count = count, .color = mp_obj_get_int(color_in) };
 
-                point[idx].x = mp_obj_get_int(point_from_poly[0]);
-                point[idx].y = mp_obj_get_int(point_from_poly[1]);
-            }
+	refresh_batch(self, batch_lines, &batch);
+	return mp_const_none;
+}
 
-            Point center = {cx, cy};
-            Polygon polygon = {poly_len, self->work};
+static MP_DEFINE_CONST_FUN_OBJ_3(amoled_AMOLED_lines_obj, amoled_AMOLED_lines);
 
-            if (angle != 0) {
-                rotate_polygon(&polygon, center, angle);
-            }
 
-            Point location = {x, y};
-            fill_polygon(self, &polygon, location, color);
+static void batch_polyline(amoled_AMOLED_obj_t *self, const amoled_batch_t *batch) {
+	const int16_t *xy = batch->rec;
+	size_t count = batch->count;
 
-            heap_caps_free(self->work);
-            self->work = NULL;
-        } else {
-            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
-        }
+	for (size_t i = 1; i < count; i++) {
+		line(self, xy[2 * i - 2], xy[2 * i - 1], xy[2 * i], xy[2 * i + 1], batch->color);
+	}
+	if (batch->closed && (count > 2)) {
+		line(self, xy[2 * count - 2], xy[2 * count - 1], xy[0], xy[1], batch->color);
+	}
+}
 
-    } else {
-        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
-    }
+//	polyline(coords, color[, closed]) : coords holds x, y pairs joined by lines, the last one to the first when closed
+static mp_obj_t amoled_AMOLED_polyline(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	const int16_t *xy;
+	size_t count = batch_buffer(args[1], 2, &xy);
+	amoled_batch_t batch = { .rec = xy, .count = count, .color = mp_obj_get_int(args[2]) };
 
-    return mp_const_none;
+	batch.closed = (n_args > 3) && mp_obj_is_true(args[3]);
+	refresh_batch(self, batch_polyline, &batch);
+	return mp_const_none;
 }
 
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_fill_polygon_obj, 5, 8, amoled_AMOLED_fill_polygon);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_polyline_obj, 3, 4, amoled_AMOLED_polyline);
 
 
 /*-----------------------------------------------------------------------------------------------------
@@ -1843,30 +3642,31 @@ Below are Monospaced fond related functions
 ------------------------------------------------------------------------------------------------------*/
 
 
-//	text(font_module, string, x, y[, fg, bg])
-static mp_obj_t amoled_AMOLED_text(size_t n_args, const mp_obj_t *args) {
-    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    mp_obj_module_t *font = MP_OBJ_TO_PTR(args[1]);  		// Arg n°1 is the font pointer (font)
-	const char *str_8 = (char *) mp_obj_str_get_str(args[2]);
-	size_t str_8_len = strlen(str_8);
-    mp_int_t x = mp_obj_get_int(args[3]);					// Arg n°3 is x_position x
-    mp_int_t y = mp_obj_get_int(args[4]);					// Arg n°4 is y_position y
-	mp_int_t fg_color = (n_args > 5) ? mp_obj_get_int(args[5]) : WHITE; // Arg 5 if front Color;
-    mp_int_t bg_color  = (n_args > 6) ? mp_obj_get_int(args[6]) : BLACK; // Aarg 6 is back color;
-	// if no Arg 6, we will not overwrite frame buffer	
-	bool bg_filled = (n_args > 6) ? true : false;
-	
-	//Map font datas
-    mp_obj_dict_t *dict = MP_OBJ_TO_PTR(font->globals);		// dict points to Font object (font)
-    const uint8_t width = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_WIDTH)));	 	// witdh is the font width
-    const uint8_t height = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_HEIGHT)));		// height...
-    const uint8_t first = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_FIRST)));		// first character
-    const uint8_t last = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_LAST)));			// last char.
+//Map a text() font module once, it can then be drawn without dict lookups
+static void text_font(mp_obj_t font_in, amoled_font_t *font) {
+    mp_obj_module_t *module = MP_OBJ_TO_PTR(font_in);
+    mp_obj_dict_t *dict = MP_OBJ_TO_PTR(module->globals);		// dict points to Font object (font)
+    font->width = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_WIDTH)));	 	// witdh is the font width
+    font->height = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_HEIGHT)));		// height...
+    font->first = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_FIRST)));		// first character
+    font->last = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_LAST)));			// last char.
+
+    mp_obj_t font_data_buff = mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_FONT));				// font_data_buff is the font buff
+    mp_buffer_info_t bufinfo;																	// bufinfo is the buffer interrupt
+    mp_get_buffer_raise(font_data_buff, &bufinfo, MP_BUFFER_READ);								// 
+    font->data = bufinfo.buf;																	// font_data is bufinfo.buf data pointer  
+}
+
+//Draw a string with a mapped text() font, fg and bg are API colors
+static void text_draw(amoled_AMOLED_obj_t *self, const amoled_font_t *font, const char *str_8, size_t str_8_len, mp_int_t x, mp_int_t y, mp_int_t fg_color, mp_int_t bg_color, bool bg_filled) {
+    const uint8_t width = font->width;
+    const uint8_t height = font->height;
+    const uint8_t first = font->first;
+    const uint8_t last = font->last;
+    const uint8_t *font_data = font->data;
 
-    mp_obj_t font_data_buff = mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_FONT));						// font_data_buff is the font buff
-    mp_buffer_info_t bufinfo;																			// bufinfo is the buffer interrupt
-    mp_get_buffer_raise(font_data_buff, &bufinfo, MP_BUFFER_READ);										// 
-    const uint8_t *font_data = bufinfo.buf;																// font_data is bufinfo.buf data pointer  
+	fg_color = fb_color(self, fg_color);
+	bg_color = fb_color(self, bg_color);
 
     uint8_t wide = width / 8; // wide = width in Bytes for a single char (ex 16bit large font is 2 bytes per line)
 	mp_int_t x0 = x;
@@ -1877,19 +3677,25 @@ static mp_obj_t amoled_AMOLED_text(size_t n_args, const mp_obj_t *args) {
 		chr = str_8[i];
         if (chr >= first && chr <= last) {	// if string character is in the font character range 
 			if (x + width >= self->width) {
-				return mp_const_none;  // return if char is away from dsplay
+				return;  // return if char is away from dsplay
 			}
             uint16_t chr_idx = (chr - first) * (height * wide);	// chr_index is the charactere index in the font file 
 			size_t fram_buf_idx;  //bud_index is the framebuffer index
 			for (uint8_t line = 0; line < height; line++) {		// for every line of the font character
 				fram_buf_idx = (y + line) * self->width + x;	// buf_idx is the frame buffer start index for each line
+				uint16_t *row = fb_row16(self, fram_buf_idx);
+				if (row) {	// whole line at once
+					amoled_expand1(row, &font_data[chr_idx], 0, fg_color, bg_color, bg_filled, wide * 8);
+					chr_idx += wide;
+					continue;
+				}
 				for (uint8_t line_byte = 0; line_byte < wide; line_byte++) { 	//for wide bytes of every line 
                     uint8_t chr_data = font_data[chr_idx];					 	// get corresponding data
                     for (uint8_t bit = 8; bit; bit--) {						 	// for every bits of the font
 						if (chr_data >> (bit - 1) & 1) {	// 1 = Front color / 0 = back_color
-                            self->fram_buf[fram_buf_idx] = fg_color;	
+                            fb_put(self, fram_buf_idx, fg_color);	
                         } else {
-							if (bg_filled) { self->fram_buf[fram_buf_idx] = bg_color; }  //Fill background only if asked
+							if (bg_filled) { fb_put(self, fram_buf_idx, bg_color); }  //Fill background only if asked
                         }
                         fram_buf_idx++;	// next frame buffer index and proceed next font bit
                     }
@@ -1900,6 +3706,20 @@ static mp_obj_t amoled_AMOLED_text(size_t n_args, const mp_obj_t *args) {
         }	// if not in font character range = Do nothing
     } // all source character proceeded
 	refresh_display(self,x0,y,x - x0,height);
+}
+
+//	text(font_module, string, x, y[, fg, bg])
+static mp_obj_t amoled_AMOLED_text(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	amoled_font_t font;
+	text_font(args[1], &font);								// Arg n°1 is the font module
+	const char *str_8 = (char *) mp_obj_str_get_str(args[2]);
+    mp_int_t x = mp_obj_get_int(args[3]);					// Arg n°3 is x_position x
+    mp_int_t y = mp_obj_get_int(args[4]);					// Arg n°4 is y_position y
+	mp_int_t fg_color = (n_args > 5) ? mp_obj_get_int(args[5]) : WHITE; // Arg 5 if front Color;
+    mp_int_t bg_color = (n_args > 6) ? mp_obj_get_int(args[6]) : BLACK; // Aarg 6 is back color;
+	// if no Arg 6, we will not overwrite frame buffer	
+	text_draw(self, &font, str_8, strlen(str_8), x, y, fg_color, bg_color, n_args > 6);
     return mp_const_none;
 }
 
@@ -1950,43 +3770,46 @@ Below are Variable Fonts related functions
 ----------------------------------------------------------------------------------------------------*/
 
 
-//	write(font_module, string, x, y[, fg, bg)
-static mp_obj_t amoled_AMOLED_write(size_t n_args, const mp_obj_t *args) {
-    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-    mp_obj_module_t *font = MP_OBJ_TO_PTR(args[1]);
-	const char *str_8 = (char *) mp_obj_str_get_str(args[2]);
-	size_t str_8_len = strlen(str_8);
-	mp_int_t x = mp_obj_get_int(args[3]);
-	mp_int_t y = mp_obj_get_int(args[4]);
-    mp_int_t fg_color = (n_args > 5) ? mp_obj_get_int(args[5]) : WHITE; // Arg 5 if front Color;
-    mp_int_t bg_color  = (n_args > 6) ? mp_obj_get_int(args[6]) : BLACK; // Aarg 6 is back color;
-	// if no Arg 6, we will not overwrite frame buffer	
-	bool bg_filled = (n_args > 6) ? true : false;
-	
-	uint8_t *bitmap_data = NULL;
-	
-	//Map font datas
-    mp_obj_dict_t *dict = MP_OBJ_TO_PTR(font->globals);
-    const uint8_t height = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_HEIGHT)));  // height is the font height
-    const uint8_t offset_width = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_OFFSET_WIDTH)));
+//Map a write() font module once, it can then be drawn without dict lookups
+static void write_font(mp_obj_t font_in, amoled_font_t *font) {
+    mp_obj_module_t *module = MP_OBJ_TO_PTR(font_in);
+    mp_obj_dict_t *dict = MP_OBJ_TO_PTR(module->globals);
+    font->height = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_HEIGHT)));  // height is the font height
+    font->offset_width = mp_obj_get_int(mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_OFFSET_WIDTH)));
 
     mp_obj_t widths_data_buff = mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_WIDTHS));  
     mp_buffer_info_t widths_bufinfo;
     mp_get_buffer_raise(widths_data_buff, &widths_bufinfo, MP_BUFFER_READ);
-    const uint8_t *widths_data = widths_bufinfo.buf;	// widths_data is char by char width 
+    font->widths = widths_bufinfo.buf;	// widths_data is char by char width 
 
     mp_obj_t offsets_data_buff = mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_OFFSETS));
     mp_buffer_info_t offsets_bufinfo;
     mp_get_buffer_raise(offsets_data_buff, &offsets_bufinfo, MP_BUFFER_READ);
-    const uint8_t *offsets_data = offsets_bufinfo.buf;  // offsets_data is char offset in data in order to reach each char data
+    font->offsets = offsets_bufinfo.buf;  // offsets_data is char offset in data in order to reach each char data
 
     mp_obj_t bitmaps_data_buff = mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_BITMAPS));
     mp_buffer_info_t bitmaps_bufinfo;
     mp_get_buffer_raise(bitmaps_data_buff, &bitmaps_bufinfo, MP_BUFFER_READ);
-    bitmap_data = bitmaps_bufinfo.buf; //bitmap_data is font data
+    font->data = bitmaps_bufinfo.buf; //bitmap_data is font data
 
     mp_obj_t map_obj = mp_obj_dict_get(dict, MP_OBJ_NEW_QSTR(MP_QSTR_MAP));
     GET_STR_DATA_LEN(map_obj, map_data, map_len);
+    font->map = map_data;
+    font->map_len = map_len;
+}
+
+//Draw a string with a mapped write() font, fg and bg are API colors
+static void write_draw(amoled_AMOLED_obj_t *self, const amoled_font_t *font, const char *str_8, size_t str_8_len, mp_int_t x, mp_int_t y, mp_int_t fg_color, mp_int_t bg_color, bool bg_filled) {
+    const uint8_t height = font->height;
+    const uint8_t offset_width = font->offset_width;
+    const uint8_t *widths_data = font->widths;
+    const uint8_t *offsets_data = font->offsets;
+    const uint8_t *bitmap_data = font->data;
+    const byte *map_data = font->map;
+    size_t map_len = font->map_len;
+
+    fg_color = fb_color(self, fg_color);
+    bg_color = fb_color(self, bg_color);
 	
 	size_t fram_buf_idx;
 	mp_int_t x0 = x;
@@ -2012,7 +3835,7 @@ static mp_obj_t amoled_AMOLED_write(size_t n_args, const mp_obj_t *args) {
             if (chr == map_ch) {
                 uint8_t width = widths_data[char_index];    //width is the character width
 				if (x + width >= self->width) {
-					return mp_const_none;  // return if char is away from dsplay
+					return;  // return if char is away from dsplay
 				}
                 bs_bit = 0; //bs_bit will point to the font character 1st bit; it can be offseted from 1 to 3 bits !
                 switch (offset_width) {
@@ -2035,11 +3858,17 @@ static mp_obj_t amoled_AMOLED_write(size_t n_args, const mp_obj_t *args) {
 				//Render to display		
                 for (uint16_t line = 0; line < height; line++) {  // for every line of char	
 					fram_buf_idx = (y + line) * self->width + x;	// buf_idx is the frame buffer start index for each line
+					uint16_t *row = fb_row16(self, fram_buf_idx);
+					if (row) {	// whole line at once
+						amoled_expand1(row, bitmap_data, bs_bit, fg_color, bg_color, bg_filled, width);
+						bs_bit += width;
+						continue;
+					}
                     for (uint16_t line_bits = 0; line_bits < width; line_bits++) { //for every bit of every line
 						if ((bitmap_data[bs_bit / 8] & 1 << (7 - (bs_bit % 8)))) { //Check if pixel bit if 1 or 0
-							self->fram_buf[fram_buf_idx] = fg_color;
+							fb_put(self, fram_buf_idx, fg_color);
 						} else {
-							if (bg_filled) { self->fram_buf[fram_buf_idx] = bg_color; }  //Fill background only if asked
+							if (bg_filled) { fb_put(self, fram_buf_idx, bg_color); }  //Fill background only if asked
 						}
 						bs_bit++;
 						fram_buf_idx++;
@@ -2052,6 +3881,20 @@ static mp_obj_t amoled_AMOLED_write(size_t n_args, const mp_obj_t *args) {
         }
     }
     refresh_display(self,x0,y,x - x0,height);
+}
+
+//	write(font_module, string, x, y[, fg, bg)
+static mp_obj_t amoled_AMOLED_write(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	amoled_font_t font;
+	write_font(args[1], &font);
+	const char *str_8 = (char *) mp_obj_str_get_str(args[2]);
+	mp_int_t x = mp_obj_get_int(args[3]);
+	mp_int_t y = mp_obj_get_int(args[4]);
+    mp_int_t fg_color = (n_args > 5) ? mp_obj_get_int(args[5]) : WHITE; // Arg 5 if front Color;
+    mp_int_t bg_color = (n_args > 6) ? mp_obj_get_int(args[6]) : BLACK; // Aarg 6 is back color;
+	// if no Arg 6, we will not overwrite frame buffer	
+	write_draw(self, &font, str_8, strlen(str_8), x, y, fg_color, bg_color, n_args > 6);
 	return mp_const_none;
 }
 
@@ -2410,25 +4253,10 @@ static mp_obj_t amoled_TTF_scale(size_t n_args, const mp_obj_t *args) {
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_TTF_scale_obj, 2, 3, amoled_TTF_scale);
 
 
-//Draw a TTF text :  ttf_draw(font, string, x, y[, fg, bg])
-static mp_obj_t amoled_AMOLED_ttf_draw(size_t n_args, const mp_obj_t *args) {
-    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-	SFT *sft = (SFT *) MP_OBJ_TO_PTR(args[1]);
-	//Arg1 string and transform UTF32
-	const char *str_8 = (char *) mp_obj_str_get_str(args[2]);
-	size_t str_8_len = strlen(str_8);
-	//Transform to UTF32
-	//uint32_t str_32[str_8_len];
-	//utf8_to_utf32(str_8, str_32, str_8_len);
-	//Arg2&3 are positions
-    mp_int_t x0 = mp_obj_get_int(args[3]);
-    mp_int_t y0 = mp_obj_get_int(args[4]);
-	// Arg 4 if front Color, White by default
-    mp_int_t fg_color = (n_args > 5) ? mp_obj_get_int(args[5]) : WHITE; 
-	// Arg 5 if back Color, if specified we will write over the frame buffer
-	mp_int_t bg_color = (n_args > 6) ? mp_obj_get_int(args[6]) : BLACK;
-	// if no Arg 6, we will not overwrite frame buffer	
-	bool bg_filled = (n_args > 6) ? true : false;
+//Draw a string with a TTF font, fg and bg are API colors
+static void ttf_draw(amoled_AMOLED_obj_t *self, SFT *sft, const char *str_8, size_t str_8_len, mp_int_t x0, mp_int_t y0, mp_int_t fg_color, mp_int_t bg_color, bool bg_filled) {
+	fg_color = fb_color(self, fg_color);
+	bg_color = fb_color(self, bg_color);
 	
 	mp_int_t x_nextchar = x0;
 	mp_int_t y_nextchar = y0;
@@ -2437,25 +4265,9 @@ static mp_obj_t amoled_AMOLED_ttf_draw(size_t n_args, const mp_obj_t *args) {
 	mp_int_t ymin = y0;
 	mp_int_t ymax = y0;
 
-	//Get bpp process for antialiasing process
-	uint32_t 	fltr_col_rd = self->bpp_process.fltr_col_rd;
-	uint8_t 	bitsw_col_rd = self->bpp_process.bitsw_col_rd;
-	uint32_t	fltr_col_gr = self->bpp_process.fltr_col_gr;
-	uint8_t 	bitsw_col_gr = self->bpp_process.bitsw_col_gr;
-	uint32_t	fltr_col_bl = self->bpp_process.fltr_col_bl;
-
-	//Process Fg color decomposition
-	mp_int_t fg_color_sw = (fg_color >> 8) | (fg_color << 8); //Because of Little Indian
-	mp_int_t fg_color_rd = (fg_color_sw & fltr_col_rd) >> bitsw_col_rd;
-	mp_int_t fg_color_gr = (fg_color_sw & fltr_col_gr) >> bitsw_col_gr;
-	mp_int_t fg_color_bl = (fg_color_sw & fltr_col_bl);
-		
-	// Variable to process color mitigation and final color
-	mp_int_t mfg_color_rd = 0;
-	mp_int_t mfg_color_gr = 0;
-	mp_int_t mfg_color_bl = 0;
-	mp_int_t mfg_color = 0;
-	
+	//Frame buffer pixels are byte swapped (bus order) unless native, blending works on RGB565
+	bool swap = !self->native;
+
 	SFT_Glyph g_id;
 	SFT_GMetrics g_mtx;
 	SFT_Image g_img;
@@ -2514,24 +4326,41 @@ static mp_obj_t amoled_AMOLED_ttf_draw(size_t n_args, const mp_obj_t *args) {
 		gl_idx = 0;  //Glyph pointer set to 0 at beginning
 		for (uint16_t y_gly = 0; y_gly < g_img.height; y_gly++) {		// for every line of the glyph
 			fram_buf_idx = (y_pen + y_gly) * self->width + x_pen;			// fram_buf_idx is the frame buffer start index for each line
+			uint16_t *row = fb_row16(self, fram_buf_idx);
+			if (row) {	// whole line at once, blended over the background or over what is already drawn
+				if (bg_filled) {
+					amoled_fill16(row, bg_color, g_img.width);
+				}
+				amoled_blend_alpha8(row, &pixels[gl_idx], fg_color, swap, g_img.width);
+				gl_idx += g_img.width;
+				continue;
+			}
 			for (uint16_t x_gly = 0; x_gly < g_img.width; x_gly++) {	// for every cols of the glyph
 				gl_data = g_img.pixels[gl_idx];		                	// get glyph pixel value (1 Byte)
 	
 				switch (gl_data) {
 					case 255 : // If full 255 => Plain Fg color
-						self->fram_buf[fram_buf_idx] = fg_color;
+						fb_put(self, fram_buf_idx, fg_color);
 					break;
 
 					case 0 :  // If 0 => Bg color
-						if (bg_filled) { self->fram_buf[fram_buf_idx] = bg_color; }
+						if (bg_filled) { fb_put(self, fram_buf_idx, bg_color); }
 					break;
 
 					default:	//Otherwise, moderate color if aliasing activated
-						mfg_color_rd = ((gl_data * fg_color_rd) >> 8) << bitsw_col_rd;
-						mfg_color_gr = ((gl_data * fg_color_gr) >> 8) << bitsw_col_gr;
-						mfg_color_bl = (gl_data * fg_color_bl) >> 8;
-						mfg_color = ( mfg_color_rd | mfg_color_gr | mfg_color_bl);
-						self->fram_buf[fram_buf_idx] = (uint16_t) (mfg_color >> 8) | (mfg_color << 8); //Because of little indian
+						if (self->lut) {	//palette indices can't be blended, the glyph is thresholded
+							if (gl_data >= 128) {
+								fb_put(self, fram_buf_idx, fg_color);
+							} else if (bg_filled) {
+								fb_put(self, fram_buf_idx, bg_color);
+							}
+							break;
+						}
+						{	//the frame buffer can't be read in band mode, blend over the background or black
+							uint16_t color = bg_filled ? bg_color : 0;
+							amoled_blend_alpha8(&color, &gl_data, fg_color, swap, 1);
+							fb_put(self, fram_buf_idx, color);
+						}
 					break;
 				}
 				fram_buf_idx++;    // Next framebuffer pixel
@@ -2543,7 +4372,22 @@ static mp_obj_t amoled_AMOLED_ttf_draw(size_t n_args, const mp_obj_t *args) {
 	
 	//Now refresh the display from the frame_buffer (x,y,w,h)
 	refresh_display(self,x0, ymin, x_nextchar - x0 , ymax - ymin);
+}
 
+//Draw a TTF text :  ttf_draw(font, string, x, y[, fg, bg])
+static mp_obj_t amoled_AMOLED_ttf_draw(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	SFT *sft = (SFT *) MP_OBJ_TO_PTR(args[1]);
+	const char *str_8 = (char *) mp_obj_str_get_str(args[2]);
+	//Arg2&3 are positions
+    mp_int_t x0 = mp_obj_get_int(args[3]);
+    mp_int_t y0 = mp_obj_get_int(args[4]);
+	// Arg 4 if front Color, White by default
+    mp_int_t fg_color = (n_args > 5) ? mp_obj_get_int(args[5]) : WHITE; 
+	// Arg 5 if back Color, if specified we will write over the frame buffer
+	mp_int_t bg_color = (n_args > 6) ? mp_obj_get_int(args[6]) : BLACK;
+	// if no Arg 6, we will not overwrite frame buffer	
+	ttf_draw(self, sft, str_8, strlen(str_8), x0, y0, fg_color, bg_color, n_args > 6);
     return mp_const_none;
 }
 
@@ -2623,6 +4467,8 @@ static mp_obj_t amoled_AMOLED_bitmap(size_t n_args, const mp_obj_t *args) {
     set_area(self, x_start, y_start, x_end, y_end);
     size_t len = ((x_end - x_start) * (y_end - y_start) * self->Bpp);
     write_color(self, bufinfo.buf, len);
+    wait_panel(self);    // buf belongs to micropython and may be freed as soon as we return
+    panel_check(self);
 
     return mp_const_none;
 }
@@ -2667,7 +4513,7 @@ static int out_fast(JDEC *jd,void *bitmap, JRECT *rect) {
     bws = 2 * (rect->right - rect->left + 1);                       // Width of source rectangular [byte]
     bwd = 2 * dev->wfbuf;                                           // Width of frame buffer [byte]
     for (y = rect->top; y <= rect->bottom; y++) {
-        memcpy(dst, src, bws);                                      // Copy a line
+        amoled_copy16((uint16_t *)dst, (const uint16_t *)src, bws / 2);   // Copy a line
         src += bws;
         dst += bwd;                                                 // Next line
     }
@@ -2676,11 +4522,11 @@ static int out_fast(JDEC *jd,void *bitmap, JRECT *rect) {
 
 
 // Draw jpg from a file at x, y
-static mp_obj_t amoled_AMOLED_jpg(size_t n_args, const mp_obj_t *args) {
-    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
-	const char *filename = mp_obj_str_get_str(args[1]);
-	mp_int_t x = mp_obj_get_int(args[2]);
-	mp_int_t y = mp_obj_get_int(args[3]);
+//Decode a jpg file into the frame buffer at x, y
+static void jpg_draw(amoled_AMOLED_obj_t *self, const char *filename, mp_int_t x, mp_int_t y) {
+	if (self->lut || self->band_ops) {
+		mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("jpg needs a color frame buffer"));
+	}
 
     int (*outfunc)(JDEC *, void *, JRECT *);
 
@@ -2722,7 +4568,7 @@ static mp_obj_t amoled_AMOLED_jpg(size_t n_args, const mp_obj_t *args) {
 					fram_buf_idx = (y + line)*self->width + x;
 					for(uint16_t col=0; col < jdec.width; col++) {
 						color = devid.fbuf[jpg_idx+1] << 8 | devid.fbuf[jpg_idx];
-						self->fram_buf[fram_buf_idx] = color;
+						self->fram_buf[fram_buf_idx] = fb_color(self, color);
 						fram_buf_idx++;
 						jpg_idx += 2;
 					}
@@ -2744,6 +4590,16 @@ static mp_obj_t amoled_AMOLED_jpg(size_t n_args, const mp_obj_t *args) {
 	//Refresh display (whole display for now)
 	refresh_display(self,0,0,self->width,self->height);
 	//refresh_display(self,x,y,jdec.width,jdec.height);
+}
+
+//	jpg(filename, x, y)
+static mp_obj_t amoled_AMOLED_jpg(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	const char *filename = mp_obj_str_get_str(args[1]);
+	mp_int_t x = mp_obj_get_int(args[2]);
+	mp_int_t y = mp_obj_get_int(args[3]);
+
+	jpg_draw(self, filename, x, y);
 	return mp_const_none;
 }
 
@@ -2768,11 +4624,11 @@ static int out_crop(JDEC *jd, void *bitmap, JRECT *rect) {
 			uint16_t bottom = MIN(dev->bottom, rect->bottom);
 			uint16_t dev_width = dev->right - dev->left + 1;
 			uint16_t rect_width = rect->right - rect->left + 1;
-			uint16_t width = (right - left + 1) * 2;
+			uint16_t width = right - left + 1;
 			uint16_t row;
 
 			for (row = top; row <= bottom; row++) {
-				memcpy(
+				amoled_copy16(
 					(uint16_t *)dev->fbuf + ((row - dev->top) * dev_width) + left - dev->left,
 					(uint16_t *)bitmap + ((row - rect->top) * rect_width) + left - rect->left,
 					width);
@@ -3006,7 +4862,22 @@ static mp_obj_t amoled_AMOLED_rotation(size_t n_args, const mp_obj_t *args) {
             }
         }
     }
+    if (self->stage_size < 2 * self->rotations[self->rotation].width * self->Bpp) {
+        mp_raise_ValueError(MP_ERROR_TEXT("stage_size too small"));
+    }
+    if (self->front_buf) {	//double buffer : the worker may still send, the next swap() sends the whole screen
+        present_wait(self);
+        drop_damage(self);
+    } else {
+        flush_damage(self);		//pending areas belong to the previous rotation
+    }
+    self->band_count = 0;	//and so does the display list
     set_rotation(self, self->rotation);
+    if (self->front_buf && (self->auto_refresh == AUTO_REFRESH_DEFERRED)) {
+        amoled_area_t area;
+        align_area(self, 0, 0, self->width, self->height, &area);
+        damage_add(self, &area);
+    }
     return mp_const_none;
 }
 
@@ -3039,6 +4910,65 @@ static mp_obj_t amoled_AMOLED_tearing(size_t n_args, const mp_obj_t *args) {
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_tearing_obj, 2, 3, amoled_AMOLED_tearing);
 
 
+//Get or set the frame pacer target fps (0 : no pacing, refreshes only wait for the TE edge if any)
+static mp_obj_t amoled_AMOLED_pacing(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    if (n_args > 1) {
+		mp_float_t fps = mp_obj_get_float(args[1]);
+		if (fps < 0) {
+			mp_raise_ValueError(MP_ERROR_TEXT("fps must be positive"));
+		}
+		present_wait(self);
+		self->te_sync.frame_us = (fps > 0) ? (uint32_t)(1000000 / fps) : 0;
+		self->te_sync.next_us = 0;
+	}
+	return mp_obj_new_float(self->te_sync.frame_us ? (mp_float_t)1000000 / self->te_sync.frame_us : 0);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_pacing_obj, 1, 2, amoled_AMOLED_pacing);
+
+
+//Replace the TE pin by a fake TE of the given frequency in Hz (0 : no TE)
+static mp_obj_t amoled_AMOLED_fake_te(mp_obj_t self_in, mp_obj_t hz_in) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	mp_float_t hz = mp_obj_get_float(hz_in);
+
+	if (hz < 0) {
+		mp_raise_ValueError(MP_ERROR_TEXT("frequency must be positive"));
+	}
+	present_wait(self);
+	amoled_te_timer(&self->te_sync, (hz > 0) ? (uint32_t)(1000000 / hz) : 0);
+	return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_2(amoled_AMOLED_fake_te_obj, amoled_AMOLED_fake_te);
+
+
+//Pacing statistics : (frames, late frames, missed frame slots, TE timeouts, TE period in us), reset if arg is True
+static mp_obj_t amoled_AMOLED_pacing_stats(size_t n_args, const mp_obj_t *args) {
+    amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	amoled_te_t *te = &self->te_sync;
+	mp_obj_t stats[5] = {
+		mp_obj_new_int_from_uint(te->frames),
+		mp_obj_new_int_from_uint(te->late),
+		mp_obj_new_int_from_uint(te->missed),
+		mp_obj_new_int_from_uint(te->timeouts),
+		mp_obj_new_int_from_uint(te->period_us)
+	};
+
+	if ((n_args > 1) && mp_obj_is_true(args[1])) {
+		te->frames   = 0;
+		te->late     = 0;
+		te->missed   = 0;
+		te->timeouts = 0;
+	}
+	return mp_obj_new_tuple(5, stats);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_pacing_stats_obj, 1, 2, amoled_AMOLED_pacing_stats);
+
+
 
 static mp_obj_t amoled_AMOLED_vscroll_area(size_t n_args, const mp_obj_t *args) {
     amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
@@ -3098,6 +5028,313 @@ static mp_obj_t amoled_AMOLED_vscroll_start(size_t n_args, const mp_obj_t *args)
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_vscroll_start_obj, 2, 3, amoled_AMOLED_vscroll_start);
 
 
+/*---------------------------------------------------------------------------------------------------
+Below are display list related functions
+----------------------------------------------------------------------------------------------------*/
+
+
+//Create an empty display list : DisplayList()
+mp_obj_t amoled_DisplayList_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args) {
+	mp_arg_check_num(n_args, n_kw, 0, 0, false);
+
+	amoled_dlist_obj_t *self = m_new_obj(amoled_dlist_obj_t);
+	memset(self, 0, sizeof(*self));
+	self->base.type = &amoled_DisplayList_type;
+	self->objs = mp_obj_new_list(0, NULL);
+	return MP_OBJ_FROM_PTR(self);
+}
+
+static void amoled_DisplayList_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t  kind) {
+    (void) kind;
+    amoled_dlist_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "<AMOLED DisplayList - Ops=%u, Bytes=%u>", self->count, (unsigned int)self->len);
+}
+
+//Append an op followed by data_len bytes of data, the op is cleared
+static amoled_dl_op_t *dlist_add(amoled_dlist_obj_t *self, uint8_t op, size_t data_len) {
+	size_t size = sizeof(amoled_dl_op_t) + ((data_len + 7) & ~7);		//ops stay aligned for Point data
+
+	if ((size - sizeof(amoled_dl_op_t) > 0xFFFF) || (self->count == 0xFFFF)) {
+		mp_raise_ValueError(MP_ERROR_TEXT("display list entry too large"));
+	}
+	if (self->len + size > self->alloc) {
+		size_t alloc = MAX(self->alloc * 2, self->len + size);
+		self->code = m_renew(uint8_t, self->code, self->alloc, alloc);
+		self->alloc = alloc;
+	}
+	amoled_dl_op_t *o = (amoled_dl_op_t *)&self->code[self->len];
+	memset(o, 0, size);
+	o->op = op;
+	o->len = size - sizeof(amoled_dl_op_t);
+	self->len += size;
+	self->count++;
+	return o;
+}
+
+//Keep an object used by the ops alive, returns its index in objs
+static uint16_t dlist_ref(amoled_dlist_obj_t *self, mp_obj_t obj) {
+	size_t len;
+	mp_obj_t *items;
+	mp_obj_list_get(self->objs, &len, &items);
+	for (size_t i = 0; i < len; i++) {
+		if (items[i] == obj) {
+			return i;
+		}
+	}
+	mp_obj_list_append(self->objs, obj);
+	return len;
+}
+
+//Record a shape : (x, y, [a, [b,]] color) or (color) for fill
+static mp_obj_t dlist_shape(size_t n_args, const mp_obj_t *args, uint8_t op) {
+	amoled_dlist_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	mp_int_t v[4] = {0, 0, 0, 0};
+
+	for (size_t i = 1; i < n_args - 1; i++) {
+		v[i - 1] = mp_obj_get_int(args[i]);
+	}
+	amoled_dl_op_t *o = dlist_add(self, op, 0);
+	o->x = v[0];
+	o->y = v[1];
+	o->a = v[2];
+	o->b = v[3];
+	o->fg = mp_obj_get_int(args[n_args - 1]);
+	return mp_const_none;
+}
+
+//Record a string : (font, string, x, y[, fg, bg]), bitmap fonts are mapped now
+static mp_obj_t dlist_string(size_t n_args, const mp_obj_t *args, uint8_t op) {
+	amoled_dlist_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	size_t str_len;
+	const char *str = mp_obj_str_get_data(args[2], &str_len);
+
+	if (str_len > INT16_MAX) {		//kept in the int16 a of the op
+		mp_raise_ValueError(MP_ERROR_TEXT("string too long"));
+	}
+	uint16_t ref = dlist_ref(self, args[1]);
+
+	if (op != DL_TTF) {
+		amoled_font_t font;
+		if (op == DL_TEXT) {
+			text_font(args[1], &font);
+		} else {
+			write_font(args[1], &font);
+		}
+		self->fonts = m_renew(amoled_font_t, self->fonts, self->font_count, self->font_count + 1);
+		self->fonts[self->font_count] = font;
+		ref = self->font_count++;
+	}
+
+	amoled_dl_op_t *o = dlist_add(self, op, str_len + 1);
+	memcpy(o + 1, str, str_len);
+	o->a = str_len;
+	o->x = mp_obj_get_int(args[3]);
+	o->y = mp_obj_get_int(args[4]);
+	o->fg = (n_args > 5) ? mp_obj_get_int(args[5]) : WHITE;
+	o->bg = (n_args > 6) ? mp_obj_get_int(args[6]) : BLACK;
+	o->bg_filled = n_args > 6;
+	o->ref = ref;
+	return mp_const_none;
+}
+
+//Record a polygon : (points, x, y, color[, angle, cx, cy[, rule]]), points are rotated now
+static mp_obj_t dlist_polygon(size_t n_args, const mp_obj_t *args, uint8_t op) {
+	amoled_dlist_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	mp_float_t angle = (n_args > 5) ? mp_obj_get_float(args[5]) : 0.0f;
+	Point center = { (n_args > 6) ? mp_obj_get_int(args[6]) : 0, (n_args > 7) ? mp_obj_get_int(args[7]) : 0 };
+	if ((op == DL_POLYGON) ? (angle <= 0) : (angle == 0)) {		//same rules as polygon() and fill_polygon()
+		angle = 0;
+	}
+	mp_int_t rule = (n_args > 8) ? mp_obj_get_int(args[8]) : FILL_EVEN_ODD;
+	if ((rule != FILL_EVEN_ODD) && (rule != FILL_NON_ZERO)) {
+		mp_raise_ValueError(MP_ERROR_TEXT("rule must be EVEN_ODD or NON_ZERO"));
+	}
+
+	amoled_dl_op_t *o;
+	size_t poly_len;
+	if (mp_obj_is_type(args[1], &amoled_Polygon_type)) {
+		amoled_polygon_obj_t *poly = MP_OBJ_TO_PTR(args[1]);
+		poly_len = poly->length;
+		o = dlist_add(self, op, poly_len * sizeof(Point));
+		memcpy(o + 1, polygon_rotated(poly, angle, center), poly_len * sizeof(Point));
+	} else {
+		mp_obj_t *polygon;
+		mp_obj_get_array(args[1], &poly_len, &polygon);
+		if (poly_len == 0) {
+			mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Polygon data error"));
+		}
+		o = dlist_add(self, op, poly_len * sizeof(Point));
+		polygon_parse(polygon, poly_len, (Point *)(o + 1));
+		if (angle != 0) {
+			Polygon poly = { poly_len, (Point *)(o + 1) };
+			rotate_polygon(&poly, center, angle);
+		}
+	}
+	o->a = poly_len;
+	o->x = mp_obj_get_int(args[2]);
+	o->y = mp_obj_get_int(args[3]);
+	o->fg = mp_obj_get_int(args[4]);
+	o->b = rule;
+	return mp_const_none;
+}
+
+static mp_obj_t amoled_DisplayList_fill(size_t n_args, const mp_obj_t *args) { return dlist_shape(n_args, args, DL_FILL); }
+static mp_obj_t amoled_DisplayList_pixel(size_t n_args, const mp_obj_t *args) { return dlist_shape(n_args, args, DL_PIXEL); }
+static mp_obj_t amoled_DisplayList_hline(size_t n_args, const mp_obj_t *args) { return dlist_shape(n_args, args, DL_HLINE); }
+static mp_obj_t amoled_DisplayList_vline(size_t n_args, const mp_obj_t *args) { return dlist_shape(n_args, args, DL_VLINE); }
+static mp_obj_t amoled_DisplayList_line(size_t n_args, const mp_obj_t *args) { return dlist_shape(n_args, args, DL_LINE); }
+static mp_obj_t amoled_DisplayList_rect(size_t n_args, const mp_obj_t *args) { return dlist_shape(n_args, args, DL_RECT); }
+static mp_obj_t amoled_DisplayList_fill_rect(size_t n_args, const mp_obj_t *args) { return dlist_shape(n_args, args, DL_FILL_RECT); }
+static mp_obj_t amoled_DisplayList_circle(size_t n_args, const mp_obj_t *args) { return dlist_shape(n_args, args, DL_CIRCLE); }
+static mp_obj_t amoled_DisplayList_fill_circle(size_t n_args, const mp_obj_t *args) { return dlist_shape(n_args, args, DL_FILL_CIRCLE); }
+static mp_obj_t amoled_DisplayList_text(size_t n_args, const mp_obj_t *args) { return dlist_string(n_args, args, DL_TEXT); }
+static mp_obj_t amoled_DisplayList_write(size_t n_args, const mp_obj_t *args) { return dlist_string(n_args, args, DL_WRITE); }
+static mp_obj_t amoled_DisplayList_ttf_draw(size_t n_args, const mp_obj_t *args) { return dlist_string(n_args, args, DL_TTF); }
+static mp_obj_t amoled_DisplayList_polygon(size_t n_args, const mp_obj_t *args) { return dlist_polygon(n_args, args, DL_POLYGON); }
+static mp_obj_t amoled_DisplayList_fill_polygon(size_t n_args, const mp_obj_t *args) { return dlist_polygon(n_args, args, DL_FILL_POLYGON); }
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_fill_obj, 2, 2, amoled_DisplayList_fill);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_pixel_obj, 4, 4, amoled_DisplayList_pixel);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_hline_obj, 5, 5, amoled_DisplayList_hline);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_vline_obj, 5, 5, amoled_DisplayList_vline);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_line_obj, 6, 6, amoled_DisplayList_line);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_rect_obj, 6, 6, amoled_DisplayList_rect);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_fill_rect_obj, 6, 6, amoled_DisplayList_fill_rect);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_circle_obj, 5, 5, amoled_DisplayList_circle);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_fill_circle_obj, 5, 5, amoled_DisplayList_fill_circle);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_text_obj, 5, 7, amoled_DisplayList_text);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_write_obj, 5, 7, amoled_DisplayList_write);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_ttf_draw_obj, 5, 7, amoled_DisplayList_ttf_draw);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_polygon_obj, 5, 8, amoled_DisplayList_polygon);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_fill_polygon_obj, 5, 9, amoled_DisplayList_fill_polygon);
+
+
+//Record a jpg : jpg(filename, x, y), the file is decoded by every play()
+static mp_obj_t amoled_DisplayList_jpg(size_t n_args, const mp_obj_t *args) {
+	amoled_dlist_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	size_t name_len;
+	const char *filename = mp_obj_str_get_data(args[1], &name_len);
+
+	amoled_dl_op_t *o = dlist_add(self, DL_JPG, name_len + 1);
+	memcpy(o + 1, filename, name_len);
+	o->x = mp_obj_get_int(args[2]);
+	o->y = mp_obj_get_int(args[3]);
+	return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_DisplayList_jpg_obj, 4, 4, amoled_DisplayList_jpg);
+
+
+//Forget every recorded op
+static mp_obj_t amoled_DisplayList_clear(mp_obj_t self_in) {
+	amoled_dlist_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	self->len = 0;
+	self->count = 0;
+	self->font_count = 0;
+	self->objs = mp_obj_new_list(0, NULL);
+	return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_DisplayList_clear_obj, amoled_DisplayList_clear);
+
+
+//Returns (ops, bytes)
+static mp_obj_t amoled_DisplayList_size(mp_obj_t self_in) {
+	amoled_dlist_obj_t *self = MP_OBJ_TO_PTR(self_in);
+	mp_obj_t size[2] = {
+		mp_obj_new_int_from_uint(self->count),
+		mp_obj_new_int_from_uint(self->len)
+	};
+	return mp_obj_new_tuple(2, size);
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_DisplayList_size_obj, amoled_DisplayList_size);
+
+
+//Replay the ops of a display list moved by dx, dy
+static void play_ops(amoled_AMOLED_obj_t *self, const amoled_batch_t *batch) {
+	amoled_dlist_obj_t *dl = batch->dl;
+	mp_int_t dx = batch->dx, dy = batch->dy;
+	size_t objs_len;
+	mp_obj_t *objs;
+	mp_obj_list_get(dl->objs, &objs_len, &objs);
+
+	for (size_t pos = 0; pos < dl->len; ) {
+		const amoled_dl_op_t *o = (const amoled_dl_op_t *)&dl->code[pos];
+		const void *data = o + 1;
+		mp_int_t x = o->x + dx;
+		mp_int_t y = o->y + dy;
+
+		switch (o->op) {
+			case DL_FILL:
+				fill_frame_buffer(self, o->fg, 0, 0, self->width, self->height);
+			break;
+			case DL_PIXEL:
+				pixel(self, x, y, o->fg);
+			break;
+			case DL_HLINE:
+				fast_hline(self, x, y, o->a, o->fg);
+			break;
+			case DL_VLINE:
+				fast_vline(self, x, y, o->a, o->fg);
+			break;
+			case DL_LINE:
+				line(self, x, y, o->a + dx, o->b + dy, o->fg);
+			break;
+			case DL_RECT:
+				rect(self, x, y, o->a, o->b, o->fg);
+			break;
+			case DL_FILL_RECT:
+				fill_rect(self, x, y, o->a, o->b, o->fg);
+			break;
+			case DL_CIRCLE:
+				circle(self, x, y, o->a, o->fg);
+			break;
+			case DL_FILL_CIRCLE:
+				fill_circle(self, x, y, o->a, o->fg);
+			break;
+			case DL_TEXT:
+				text_draw(self, &dl->fonts[o->ref], data, o->a, x, y, o->fg, o->bg, o->bg_filled);
+			break;
+			case DL_WRITE:
+				write_draw(self, &dl->fonts[o->ref], data, o->a, x, y, o->fg, o->bg, o->bg_filled);
+			break;
+			case DL_TTF:
+				ttf_draw(self, MP_OBJ_TO_PTR(objs[o->ref]), data, o->a, x, y, o->fg, o->bg, o->bg_filled);
+			break;
+			case DL_POLYGON:
+				polygon_draw(self, data, o->a, x, y, o->fg);
+			break;
+			case DL_FILL_POLYGON: {
+				Polygon polygon = { o->a, (Point *)data };
+				fill_polygon(self, &polygon, (Point) { x, y }, o->fg, o->b, false, NULL);
+			}
+			break;
+			case DL_JPG:
+				jpg_draw(self, data, x, y);
+			break;
+		}
+		pos += sizeof(amoled_dl_op_t) + o->len;
+	}
+}
+
+//	play(display_list[, dx, dy]) : replay recorded drawings moved by dx, dy, the display is refreshed once
+static mp_obj_t amoled_AMOLED_play(size_t n_args, const mp_obj_t *args) {
+	amoled_AMOLED_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+	if (!mp_obj_is_type(args[1], &amoled_DisplayList_type)) {
+		mp_raise_TypeError(MP_ERROR_TEXT("play needs a DisplayList"));
+	}
+	amoled_batch_t batch = { .dl = MP_OBJ_TO_PTR(args[1]) };
+
+	batch.dx = (n_args > 2) ? mp_obj_get_int(args[2]) : 0;
+	batch.dy = (n_args > 3) ? mp_obj_get_int(args[3]) : 0;
+	refresh_batch(self, play_ops, &batch);		//an op failing still refreshes the areas already drawn
+	return mp_const_none;
+}
+
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_AMOLED_play_obj, 2, 4, amoled_AMOLED_play);
+
+
 /*---------------------------------------------------------------------------------------------------
 Below are C to Micropython library dictionnary
 ----------------------------------------------------------------------------------------------------*/
@@ -3111,6 +5348,23 @@ static const mp_rom_map_elem_t amoled_AMOLED_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_init),            MP_ROM_PTR(&amoled_AMOLED_init_obj)            },
     { MP_ROM_QSTR(MP_QSTR_send_cmd),        MP_ROM_PTR(&amoled_AMOLED_send_cmd_obj)        },
     { MP_ROM_QSTR(MP_QSTR_refresh),         MP_ROM_PTR(&amoled_AMOLED_refresh_obj)         },
+    { MP_ROM_QSTR(MP_QSTR_flush),           MP_ROM_PTR(&amoled_AMOLED_flush_obj)           },
+    { MP_ROM_QSTR(MP_QSTR_swap),            MP_ROM_PTR(&amoled_AMOLED_swap_obj)            },
+    { MP_ROM_QSTR(MP_QSTR_present_stats),   MP_ROM_PTR(&amoled_AMOLED_present_stats_obj)   },
+    { MP_ROM_QSTR(MP_QSTR_band_stats),      MP_ROM_PTR(&amoled_AMOLED_band_stats_obj)      },
+    { MP_ROM_QSTR(MP_QSTR_play),            MP_ROM_PTR(&amoled_AMOLED_play_obj)            },
+    { MP_ROM_QSTR(MP_QSTR_pixels),          MP_ROM_PTR(&amoled_AMOLED_pixels_obj)          },
+    { MP_ROM_QSTR(MP_QSTR_hlines),          MP_ROM_PTR(&amoled_AMOLED_hlines_obj)          },
+    { MP_ROM_QSTR(MP_QSTR_fill_rects),      MP_ROM_PTR(&amoled_AMOLED_fill_rects_obj)      },
+    { MP_ROM_QSTR(MP_QSTR_lines),           MP_ROM_PTR(&amoled_AMOLED_lines_obj)           },
+    { MP_ROM_QSTR(MP_QSTR_polyline),        MP_ROM_PTR(&amoled_AMOLED_polyline_obj)        },
+    { MP_ROM_QSTR(MP_QSTR_palette),         MP_ROM_PTR(&amoled_AMOLED_palette_obj)         },
+    { MP_ROM_QSTR(MP_QSTR_auto_refresh),    MP_ROM_PTR(&amoled_AMOLED_auto_refresh_obj)    },
+    { MP_ROM_QSTR(MP_QSTR_damage_stats),    MP_ROM_PTR(&amoled_AMOLED_damage_stats_obj)    },
+    { MP_ROM_QSTR(MP_QSTR_trace),           MP_ROM_PTR(&amoled_AMOLED_trace_obj)           },
+    { MP_ROM_QSTR(MP_QSTR_shadow),          MP_ROM_PTR(&amoled_AMOLED_shadow_obj)          },
+    { MP_ROM_QSTR(MP_QSTR_shadow_stats),    MP_ROM_PTR(&amoled_AMOLED_shadow_stats_obj)    },
+    { MP_ROM_QSTR(MP_QSTR_trace_dump),      MP_ROM_PTR(&amoled_AMOLED_trace_dump_obj)      },
     { MP_ROM_QSTR(MP_QSTR_pixel),           MP_ROM_PTR(&amoled_AMOLED_pixel_obj)           },
     { MP_ROM_QSTR(MP_QSTR_fill),            MP_ROM_PTR(&amoled_AMOLED_fill_obj)            },
 	{ MP_ROM_QSTR(MP_QSTR_line),            MP_ROM_PTR(&amoled_AMOLED_line_obj)            },
@@ -3124,11 +5378,21 @@ static const mp_rom_map_elem_t amoled_AMOLED_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_fill_circle),     MP_ROM_PTR(&amoled_AMOLED_fill_circle_obj)     },
     { MP_ROM_QSTR(MP_QSTR_ellipse),         MP_ROM_PTR(&amoled_AMOLED_ellipse_obj)         },
     { MP_ROM_QSTR(MP_QSTR_fill_ellipse),    MP_ROM_PTR(&amoled_AMOLED_fill_ellipse_obj)    },
+    { MP_ROM_QSTR(MP_QSTR_arc),             MP_ROM_PTR(&amoled_AMOLED_arc_obj)             },
+    { MP_ROM_QSTR(MP_QSTR_fill_arc),        MP_ROM_PTR(&amoled_AMOLED_fill_arc_obj)        },
+    { MP_ROM_QSTR(MP_QSTR_pie),             MP_ROM_PTR(&amoled_AMOLED_pie_obj)             },
 	{ MP_ROM_QSTR(MP_QSTR_trian),           MP_ROM_PTR(&amoled_AMOLED_trian_obj)           },
 	{ MP_ROM_QSTR(MP_QSTR_fill_trian),      MP_ROM_PTR(&amoled_AMOLED_fill_trian_obj)      },
     { MP_ROM_QSTR(MP_QSTR_polygon),         MP_ROM_PTR(&amoled_AMOLED_polygon_obj)         },
     { MP_ROM_QSTR(MP_QSTR_fill_polygon),    MP_ROM_PTR(&amoled_AMOLED_fill_polygon_obj)    },
     { MP_ROM_QSTR(MP_QSTR_polygon_center),  MP_ROM_PTR(&amoled_AMOLED_polygon_center_obj)  },
+    { MP_ROM_QSTR(MP_QSTR_aa_line),         MP_ROM_PTR(&amoled_AMOLED_aa_line_obj)         },
+    { MP_ROM_QSTR(MP_QSTR_aa_circle),       MP_ROM_PTR(&amoled_AMOLED_aa_circle_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_aa_fill_circle),  MP_ROM_PTR(&amoled_AMOLED_aa_fill_circle_obj)  },
+    { MP_ROM_QSTR(MP_QSTR_aa_ellipse),      MP_ROM_PTR(&amoled_AMOLED_aa_ellipse_obj)      },
+    { MP_ROM_QSTR(MP_QSTR_aa_fill_ellipse), MP_ROM_PTR(&amoled_AMOLED_aa_fill_ellipse_obj) },
+    { MP_ROM_QSTR(MP_QSTR_aa_fill_polygon), MP_ROM_PTR(&amoled_AMOLED_aa_fill_polygon_obj) },
+    { MP_ROM_QSTR(MP_QSTR_thick_line),      MP_ROM_PTR(&amoled_AMOLED_thick_line_obj)      },
     { MP_ROM_QSTR(MP_QSTR_colorRGB),        MP_ROM_PTR(&amoled_AMOLED_colorRGB_obj)        },
     { MP_ROM_QSTR(MP_QSTR_bitmap),          MP_ROM_PTR(&amoled_AMOLED_bitmap_obj)          },
     { MP_ROM_QSTR(MP_QSTR_jpg),             MP_ROM_PTR(&amoled_AMOLED_jpg_obj)             },
@@ -3153,13 +5417,24 @@ static const mp_rom_map_elem_t amoled_AMOLED_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_height),          MP_ROM_PTR(&amoled_AMOLED_height_obj)          },
     { MP_ROM_QSTR(MP_QSTR_width),           MP_ROM_PTR(&amoled_AMOLED_width_obj)           },
     { MP_ROM_QSTR(MP_QSTR_rotation),        MP_ROM_PTR(&amoled_AMOLED_rotation_obj)        },
-    { MP_ROM_QSTR(MP_QSTR_tearing),         MP_ROM_PTR(&amoled_AMOLED_tearing_obj)        },	
+    { MP_ROM_QSTR(MP_QSTR_tearing),         MP_ROM_PTR(&amoled_AMOLED_tearing_obj)        },
+    { MP_ROM_QSTR(MP_QSTR_pacing),          MP_ROM_PTR(&amoled_AMOLED_pacing_obj)          },
+    { MP_ROM_QSTR(MP_QSTR_fake_te),         MP_ROM_PTR(&amoled_AMOLED_fake_te_obj)         },
+    { MP_ROM_QSTR(MP_QSTR_pacing_stats),    MP_ROM_PTR(&amoled_AMOLED_pacing_stats_obj)    },	
     { MP_ROM_QSTR(MP_QSTR_vscroll_area),    MP_ROM_PTR(&amoled_AMOLED_vscroll_area_obj)    },
     { MP_ROM_QSTR(MP_QSTR_vscroll_start),   MP_ROM_PTR(&amoled_AMOLED_vscroll_start_obj)   },
     { MP_ROM_QSTR(MP_QSTR___del__),         MP_ROM_PTR(&amoled_AMOLED_deinit_obj)          },
     { MP_ROM_QSTR(MP_QSTR_RGB),             MP_ROM_INT(COLOR_SPACE_RGB)                    },
     { MP_ROM_QSTR(MP_QSTR_BGR),             MP_ROM_INT(COLOR_SPACE_BGR)                    },
     { MP_ROM_QSTR(MP_QSTR_MONOCHROME),      MP_ROM_INT(COLOR_SPACE_MONOCHROME)             },
+    { MP_ROM_QSTR(MP_QSTR_EVEN_ODD),        MP_ROM_INT(FILL_EVEN_ODD)                      },
+    { MP_ROM_QSTR(MP_QSTR_NON_ZERO),        MP_ROM_INT(FILL_NON_ZERO)                      },
+    { MP_ROM_QSTR(MP_QSTR_CAP_BUTT),        MP_ROM_INT(CAP_BUTT)                           },
+    { MP_ROM_QSTR(MP_QSTR_CAP_SQUARE),      MP_ROM_INT(CAP_SQUARE)                         },
+    { MP_ROM_QSTR(MP_QSTR_CAP_ROUND),       MP_ROM_INT(CAP_ROUND)                          },
+    { MP_ROM_QSTR(MP_QSTR_REFRESH_OFF),     MP_ROM_INT(AUTO_REFRESH_OFF)                   },
+    { MP_ROM_QSTR(MP_QSTR_REFRESH_ON),      MP_ROM_INT(AUTO_REFRESH_ON)                    },
+    { MP_ROM_QSTR(MP_QSTR_REFRESH_DEFERRED),MP_ROM_INT(AUTO_REFRESH_DEFERRED)              },
 };
 
 static MP_DEFINE_CONST_DICT(amoled_AMOLED_locals_dict, amoled_AMOLED_locals_dict_table);
@@ -3173,6 +5448,36 @@ static const mp_rom_map_elem_t amoled_TTF_locals_dict_table[] = {
 
 static MP_DEFINE_CONST_DICT(amoled_TTF_locals_dict, amoled_TTF_locals_dict_table);
 
+//amoled.DisplayList dictionnary
+static const mp_rom_map_elem_t amoled_DisplayList_locals_dict_table[] = {
+	{ MP_ROM_QSTR(MP_QSTR_fill),			MP_ROM_PTR(&amoled_DisplayList_fill_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_pixel),			MP_ROM_PTR(&amoled_DisplayList_pixel_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_hline),			MP_ROM_PTR(&amoled_DisplayList_hline_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_vline),			MP_ROM_PTR(&amoled_DisplayList_vline_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_line),			MP_ROM_PTR(&amoled_DisplayList_line_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_rect),			MP_ROM_PTR(&amoled_DisplayList_rect_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_fill_rect),		MP_ROM_PTR(&amoled_DisplayList_fill_rect_obj)		},
+	{ MP_ROM_QSTR(MP_QSTR_circle),			MP_ROM_PTR(&amoled_DisplayList_circle_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_fill_circle),		MP_ROM_PTR(&amoled_DisplayList_fill_circle_obj)		},
+	{ MP_ROM_QSTR(MP_QSTR_text),			MP_ROM_PTR(&amoled_DisplayList_text_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_write),			MP_ROM_PTR(&amoled_DisplayList_write_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_ttf_draw),		MP_ROM_PTR(&amoled_DisplayList_ttf_draw_obj)		},
+	{ MP_ROM_QSTR(MP_QSTR_polygon),			MP_ROM_PTR(&amoled_DisplayList_polygon_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_fill_polygon),	MP_ROM_PTR(&amoled_DisplayList_fill_polygon_obj)	},
+	{ MP_ROM_QSTR(MP_QSTR_jpg),				MP_ROM_PTR(&amoled_DisplayList_jpg_obj)				},
+	{ MP_ROM_QSTR(MP_QSTR_clear),			MP_ROM_PTR(&amoled_DisplayList_clear_obj)			},
+	{ MP_ROM_QSTR(MP_QSTR_size),			MP_ROM_PTR(&amoled_DisplayList_size_obj)			},
+};
+
+static MP_DEFINE_CONST_DICT(amoled_DisplayList_locals_dict, amoled_DisplayList_locals_dict_table);
+
+//amoled.Polygon dictionnary
+static const mp_rom_map_elem_t amoled_Polygon_locals_dict_table[] = {
+	{ MP_ROM_QSTR(MP_QSTR_center),			MP_ROM_PTR(&amoled_Polygon_center_obj)				},
+};
+
+static MP_DEFINE_CONST_DICT(amoled_Polygon_locals_dict, amoled_Polygon_locals_dict_table);
+
 
 #ifdef MP_OBJ_TYPE_GET_SLOT
 MP_DEFINE_CONST_OBJ_TYPE(
@@ -3193,6 +5498,24 @@ MP_DEFINE_CONST_OBJ_TYPE(
     locals_dict, (mp_obj_dict_t *)&amoled_TTF_locals_dict
 );
 
+MP_DEFINE_CONST_OBJ_TYPE(
+    amoled_DisplayList_type,
+    MP_QSTR_DisplayList,
+    MP_TYPE_FLAG_NONE,
+    print, amoled_DisplayList_print,
+    make_new, amoled_DisplayList_make_new,
+    locals_dict, (mp_obj_dict_t *)&amoled_DisplayList_locals_dict
+);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    amoled_Polygon_type,
+    MP_QSTR_Polygon,
+    MP_TYPE_FLAG_NONE,
+    print, amoled_Polygon_print,
+    make_new, amoled_Polygon_make_new,
+    locals_dict, (mp_obj_dict_t *)&amoled_Polygon_locals_dict
+);
+
 #else
 	
 const mp_obj_type_t amoled_AMOLED_type = {
@@ -3211,6 +5534,22 @@ const mp_obj_type_t amoled_TTF_type = {
 	.locals_dic = (mp_obj_dict_t *)&amoled_TTF_locals_dict,
 };
 
+const mp_obj_type_t amoled_DisplayList_type = {
+	{ &mp_type_type },
+	.name 		= MP_QSTR_DisplayList,
+	.print 		= amoled_DisplayList_print,
+	.make_new	= amoled_DisplayList_make_new,
+	.locals_dict = (mp_obj_dict_t *)&amoled_DisplayList_locals_dict,
+};
+
+const mp_obj_type_t amoled_Polygon_type = {
+	{ &mp_type_type },
+	.name 		= MP_QSTR_Polygon,
+	.print 		= amoled_Polygon_print,
+	.make_new	= amoled_Polygon_make_new,
+	.locals_dict = (mp_obj_dict_t *)&amoled_Polygon_locals_dict,
+};
+
 #endif
 
 
@@ -3219,11 +5558,22 @@ const mp_obj_type_t amoled_TTF_type = {
 static const mp_map_elem_t mp_module_amoled_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),   MP_OBJ_NEW_QSTR(MP_QSTR_amoled)       },
     { MP_ROM_QSTR(MP_QSTR_AMOLED),     (mp_obj_t)&amoled_AMOLED_type         },
+#ifdef ESP_PLATFORM
     { MP_ROM_QSTR(MP_QSTR_QSPIPanel),  (mp_obj_t)&amoled_qspi_bus_type       },
+#endif
+    { MP_ROM_QSTR(MP_QSTR_MockPanel),  (mp_obj_t)&amoled_mock_bus_type       },
+    { MP_ROM_QSTR(MP_QSTR_MemPanel),   (mp_obj_t)&amoled_mem_bus_type        },
     { MP_ROM_QSTR(MP_QSTR_TTF),  	   (mp_obj_t)&amoled_TTF_type       	 },
+    { MP_ROM_QSTR(MP_QSTR_DisplayList),(mp_obj_t)&amoled_DisplayList_type    },
+    { MP_ROM_QSTR(MP_QSTR_Polygon),    (mp_obj_t)&amoled_Polygon_type        },
     { MP_ROM_QSTR(MP_QSTR_RGB),        MP_ROM_INT(COLOR_SPACE_RGB)           },
     { MP_ROM_QSTR(MP_QSTR_BGR),        MP_ROM_INT(COLOR_SPACE_BGR)           },
     { MP_ROM_QSTR(MP_QSTR_MONOCHROME), MP_ROM_INT(COLOR_SPACE_MONOCHROME)    },
+    { MP_ROM_QSTR(MP_QSTR_EVEN_ODD),   MP_ROM_INT(FILL_EVEN_ODD)             },
+    { MP_ROM_QSTR(MP_QSTR_NON_ZERO),   MP_ROM_INT(FILL_NON_ZERO)             },
+    { MP_ROM_QSTR(MP_QSTR_CAP_BUTT),   MP_ROM_INT(CAP_BUTT)                  },
+    { MP_ROM_QSTR(MP_QSTR_CAP_SQUARE), MP_ROM_INT(CAP_SQUARE)                },
+    { MP_ROM_QSTR(MP_QSTR_CAP_ROUND),  MP_ROM_INT(CAP_ROUND)                 },
     { MP_ROM_QSTR(MP_QSTR_BLACK),      MP_ROM_INT(BLACK)                     },
     { MP_ROM_QSTR(MP_QSTR_BLUE),       MP_ROM_INT(BLUE)                      },
     { MP_ROM_QSTR(MP_QSTR_RED),        MP_ROM_INT(RED)                       },
@@ -8,7 +8,13 @@ extern "C" {
 #include "py/obj.h"
 #include "mpfile/mpfile.h"
 #include "schrift/schrift.h"
+#ifdef ESP_PLATFORM
 #include "amoled_qspi_bus.h"
+#endif
+#include "amoled_mock_bus.h"
+#include "amoled_mem_bus.h"
+#include "amoled_present.h"
+#include "amoled_te.h"
 
 #define LCD_CMD_NOP          0x00 // This command is empty command
 #define LCD_CMD_SWRESET      0x01 // Software reset registers (the built-in frame buffer is not affected)
@@ -107,12 +113,63 @@ extern "C" {
 #define COLOR_SPACE_BGR        (1)
 #define COLOR_SPACE_MONOCHROME (2)
 
+#define FILL_EVEN_ODD          (0) // fill_polygon() rules
+#define FILL_NON_ZERO          (1)
+#define AA_SUB                 (4) // sub rows per pixel row of anti-aliased polygons
+
+#define CAP_BUTT               (0) // thick_line() caps
+#define CAP_SQUARE             (1)
+#define CAP_ROUND              (2)
+#define CAP_SEGMENTS           (32) // max segments of a round cap
+
 #define RAM_ALIGNMENT (16)
+#define AUTO_REFRESH_OFF       (0) // Display is only updated by refresh() or flush()
+#define AUTO_REFRESH_ON        (1) // Every drawing is sent at once
+#define AUTO_REFRESH_DEFERRED  (2) // Drawings are accumulated as damaged areas and sent by flush()
+
+#define DAMAGE_MAX_RECTS       (8)   // Max number of pending damaged areas
+#define DAMAGE_MERGE_COST      (512) // Pixels a transfer costs on top of its data (CASET, RASET, RAMWR headers)
+
+#define STAGE_BUF_SIZE (0x2000)    // default size in bytes of each of the 2 refresh staging buffers
+#define SHADOW_BAND            (32)   // default width in pixels of the shadow hash cells
+#define PRESENT_MAX_AREAS      (32)   // Areas sent by one present, the last one grows when more are flushed
+#define BAND_OPS_SIZE          (1024) // default number of fills the display list of the band mode holds
+
+#define TRACE_PARAM            (0)    // trace record of a register write (tx_param)
+#define TRACE_COLOR            (1)    // trace record of a memory write (tx_color, cmd RAMWR or RAMWRC)
+#define TRACE_FRAME            (2)    // trace record marking the end of a refresh() or flush()
+#define TRACE_WINDOW_BIT       (0x80) // parameter sent with the next memory write in one tx_window call
+#define TRACE_VERSION          (1)
+
+#define DL_FILL                (0)    // display list ops, one per recorded drawing call
+#define DL_PIXEL               (1)
+#define DL_HLINE               (2)
+#define DL_VLINE               (3)
+#define DL_LINE                (4)
+#define DL_RECT                (5)
+#define DL_FILL_RECT           (6)
+#define DL_CIRCLE              (7)
+#define DL_FILL_CIRCLE         (8)
+#define DL_TEXT                (9)
+#define DL_WRITE               (10)
+#define DL_TTF                 (11)
+#define DL_POLYGON             (12)
+#define DL_FILL_POLYGON        (13)
+#define DL_JPG                 (14)
 
 
 typedef struct	_Point					Point;
 typedef struct	_Polygon				Polygon;
+typedef struct	_amoled_edge_t			amoled_edge_t;
 typedef struct	_amoled_rotation_t		amoled_rotation_t;
+typedef struct	_amoled_area_t			amoled_area_t;
+typedef struct	_amoled_trace_rec_t		amoled_trace_rec_t;
+typedef struct	_amoled_band_op_t		amoled_band_op_t;
+typedef struct	_amoled_font_t			amoled_font_t;
+typedef struct	_amoled_dl_op_t			amoled_dl_op_t;
+typedef struct	_amoled_dlist_obj_t		amoled_dlist_obj_t;
+typedef struct	_amoled_batch_t			amoled_batch_t;
+typedef struct	_amoled_polygon_obj_t	amoled_polygon_obj_t;
 typedef struct  _bpp_process_t			bpp_process_t;
 typedef struct	_amoled_AMOLED_obj_t	amoled_AMOLED_obj_t;
 typedef struct	_IODEV					IODEV;
@@ -127,6 +184,15 @@ struct _Polygon {
     Point *points;
 };
 
+// fill_polygon() edge, crossed by rows y0 to y1
+struct _amoled_edge_t {
+    int32_t x;          // 16.16 fixed point x on the current row
+    int32_t dx;         // x step per row
+    int y0;
+    int y1;
+    int dir;            // +1 downwards, -1 upwards (non zero rule)
+};
+
 struct _amoled_rotation_t {
     uint8_t madctl;
     uint16_t width;
@@ -135,6 +201,99 @@ struct _amoled_rotation_t {
     uint16_t rowstart;
 };
 
+// Display area aligned on panel constraints : SC, SR even / EC, ER odd (inclusive)
+struct _amoled_area_t {
+    uint16_t SC;
+    uint16_t SR;
+    uint16_t EC;
+    uint16_t ER;
+};
+
+// Bus trace record, dumped as is (little endian, 20 bytes) by trace_dump()
+struct _amoled_trace_rec_t {
+    uint32_t time;      // us (ticks_us)
+    uint32_t len;       // bytes sent
+    uint8_t  kind;      // TRACE_PARAM / TRACE_COLOR / TRACE_FRAME (+ TRACE_WINDOW_BIT)
+    uint8_t  cmd;       // panel command
+    uint16_t frame;     // frame number (number of TRACE_FRAME records before this one)
+    uint8_t  data[8];   // param : first 8 bytes / color : panel window as CASET and RASET params
+};
+
+// Display list entry of the band mode : a clipped rectangle fill (pixels are 1 x 1 fills)
+struct _amoled_band_op_t {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+    uint16_t color;     // panel byte order
+};
+
+// Bitmap font of text() or write() mapped once from its module, drawn again without dict lookups
+struct _amoled_font_t {
+    uint8_t  width;         // text : char width
+    uint8_t  height;
+    uint8_t  first;         // text : first and last chars
+    uint8_t  last;
+    uint8_t  offset_width;  // write : bytes per offset
+    const uint8_t *data;    // text : FONT / write : BITMAPS
+    const uint8_t *widths;  // write : WIDTHS
+    const uint8_t *offsets; // write : OFFSETS
+    const byte *map;        // write : MAP
+    size_t   map_len;
+};
+
+// Display list op, followed by len bytes of data (string, polygon points)
+struct _amoled_dl_op_t {
+    uint8_t  op;            // DL_FILL...
+    uint8_t  bg_filled;     // text ops : background is drawn
+    uint16_t len;           // bytes of data following the op (multiple of 8)
+    int16_t  x;             // position, moved by play()
+    int16_t  y;
+    int16_t  a;             // length, size, radius, end point, string length or points
+    int16_t  b;
+    uint16_t fg;            // API colors
+    uint16_t bg;
+    uint16_t ref;           // text / write : index in fonts, ttf_draw : index in objs
+    uint16_t pad[3];        // 24 bytes, the data following the op stays 8 bytes aligned (Point of doubles)
+};
+
+// amoled.DisplayList : drawing calls recorded once, replayed by AMOLED.play()
+struct _amoled_dlist_obj_t {
+    mp_obj_base_t base;
+    uint8_t  *code;         // ops
+    size_t   len;           // bytes of ops
+    size_t   alloc;         // bytes allocated
+    uint16_t count;         // number of ops
+    amoled_font_t *fonts;   // fonts mapped when recorded
+    uint16_t font_count;
+    mp_obj_t objs;          // list of the fonts and TTF objects the ops use, kept alive
+};
+
+// Arguments of a batch drawing (pixels(), hlines(), lines(), play()...) run by refresh_batch()
+struct _amoled_batch_t {
+    const int16_t *rec;     // int16 records
+    size_t   count;         // number of records
+    uint8_t  fields;        // int16 per record
+    const uint16_t *colors; // pixels() : one color per record, or NULL for color
+    uint16_t color;
+    bool     closed;        // polyline() : last point joined to the first
+    amoled_dlist_obj_t *dl; // play()
+    int      dx;
+    int      dy;
+};
+
+// amoled.Polygon : points parsed once, the last rotation is kept
+struct _amoled_polygon_obj_t {
+    mp_obj_base_t base;
+    size_t length;
+    Point *points;          // as given
+    Point *rotated;         // points rotated by angle around center
+    mp_float_t angle;
+    Point center;
+    uint8_t *edges;         // fill_polygon() edge table, kept from a fill to the next
+    size_t edges_size;
+};
+
 struct _bpp_process_t {
     uint32_t 	fltr_col_rd;
     uint8_t 	bitsw_col_rd;
@@ -157,7 +316,13 @@ struct _amoled_AMOLED_obj_t {
     uint8_t 	*trans_palette;     	// png trans_palette
     uint8_t		*gamma_table;       	// png gamma_table		
 	uint16_t 	*fram_buf;				// Global Frame buffer
+	bool 		native;					// Frame buffer holds native RGB565, bytes are swapped in the staging copy
+	uint8_t 	fram_bpp;				// Frame buffer bits per pixel : 16, or 8 with a palette
+	uint16_t 	*lut;					// Palette of 256 panel colors (NULL : frame buffer holds colors)
 	uint16_t 	*temp_buf;				// Temporary Frame buffer
+	uint16_t 	*stage_buf[2];			// Refresh staging buffers (internal DMA RAM, ping-pong)
+	uint32_t 	stage_size;				// Size of each staging buffer in bytes
+	uint8_t 	stage_idx;				// Staging buffer to fill next
 
 	// Display parameters
 	uint8_t 	type;					// Type 0 : RM67162 / 1 : RM690B0 / 3 : SH8601
@@ -174,12 +339,69 @@ struct _amoled_AMOLED_obj_t {
     uint8_t 	Bpp;					// Display Byte per pixel : 2 / 3 / 3
 	uint8_t		te;						// tearing effect 0/1
 	uint16_t    scanline;				// tearing scanline
+	amoled_te_t te_sync;				// TE source and frame pacer used by refresh(), flush() and swap()
+	amoled_area_t window;				// Last window sent with CASET / RASET (offsets included)
+	bool 		window_valid;			// False when the panel window is unknown
 	bpp_process_t bpp_process;			// bpp process filter and switches
 
 	//Frame Buffer related
-    bool 		auto_refresh;           // True => Every action is directly rendered to display
+    uint8_t 	auto_refresh;           // AUTO_REFRESH_OFF / AUTO_REFRESH_ON / AUTO_REFRESH_DEFERRED
 	bool 		hold_display;           // True => skip display refresh until decided
 	uint8_t 	bus_methode;            //FOR DEVELOPPEMENT PURPOSE
+
+	//Damage tracking (AUTO_REFRESH_DEFERRED)
+	amoled_area_t damage[DAMAGE_MAX_RECTS];	// Pending damaged areas
+	uint8_t 	damage_count;			// Number of pending damaged areas
+	uint32_t 	damage_added;			// Areas reported by drawing functions
+	uint32_t 	damage_flushed;			// Areas actually sent by flush()
+	uint64_t 	damage_requested;		// Bytes an immediate refresh would have sent
+	uint64_t 	damage_sent;			// Bytes sent by flush()
+	uint8_t 	tile_w;					// Tile width of the dirty bitmap (0 : rect list is used instead)
+	uint8_t 	tile_h;					// Tile height of the dirty bitmap
+	uint16_t 	tile_cols;				// Tiles per bitmap row (sized for the widest rotation)
+	uint16_t 	tile_rows;				// Bitmap rows (sized for the highest rotation)
+	uint32_t 	tile_dirty;				// Number of dirty tiles
+	uint8_t 	*tile_map;				// Dirty bitmap, 1 bit per tile
+
+	//Shadow GRAM : hash of each cell (2 rows x shadow_band columns) last sent to the panel
+	uint32_t 	*shadow_hash;			// Cell hashes, 0 : unknown (NULL : diff disabled)
+	uint16_t 	shadow_band;			// Cell width in pixels (even)
+	uint16_t 	shadow_cols;			// Cells per row pair (sized for the widest rotation)
+	uint16_t 	shadow_pairs;			// Row pairs (sized for the highest rotation)
+	uint32_t 	shadow_rows;			// Rows compared
+	uint32_t 	shadow_skipped;			// Rows found unchanged
+	uint64_t 	shadow_requested;		// Bytes asked to be sent
+	uint64_t 	shadow_sent;			// Bytes actually sent
+
+	//Double buffer : drawings go to fram_buf (back), the present worker sends front_buf
+	uint16_t 	*front_buf;				// Buffer being presented (NULL : single buffer)
+	amoled_present_t present;			// Present worker
+	amoled_area_t present_areas[PRESENT_MAX_AREAS];	// Areas of front_buf to send
+	uint8_t 	present_count;			// Number of areas to send
+	bool 		present_collect;		// flush_damage() fills present_areas instead of sending
+	uint32_t 	present_frames;			// Frames presented
+	uint32_t 	present_blocked;		// swap() calls that waited for the previous present
+
+	//Band mode : no frame buffer, drawings are recorded as fills and replayed strip by strip by send_area()
+	amoled_band_op_t *band_ops;			// Display list (NULL : frame buffer mode)
+	uint16_t 	band_size;				// Fills the list can hold
+	uint16_t 	band_count;				// Fills recorded
+	uint16_t 	band_rows;				// Max height of a strip
+	uint32_t 	band_strips;			// Strips sent
+	uint32_t 	band_replayed;			// Fills drawn into strips
+
+	//play() : areas refreshed by the replayed ops are gathered and refreshed once
+	bool 		play_capture;			// refresh_display() only grows the play area
+	int 		play_x0;				// play area
+	int 		play_y0;
+	int 		play_x1;
+	int 		play_y1;
+
+	//Bus trace
+	amoled_trace_rec_t *trace_buf;		// Ring of trace records (NULL : trace disabled)
+	uint32_t 	trace_size;				// Number of records of the ring
+	uint32_t 	trace_total;			// Records added since trace started (oldest ones are overwritten)
+	uint16_t 	trace_frame;			// Current frame number
 };
 
 struct _IODEV {
@@ -199,9 +421,13 @@ struct _IODEV {
 
 mp_obj_t amoled_AMOLED_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args);
 mp_obj_t amoled_TTF_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args);
+mp_obj_t amoled_DisplayList_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args);
+mp_obj_t amoled_Polygon_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args);
 
 extern const mp_obj_type_t amoled_AMOLED_type;
 extern const mp_obj_type_t amoled_TTF_type;
+extern const mp_obj_type_t amoled_DisplayList_type;
+extern const mp_obj_type_t amoled_Polygon_type;
 
 #ifdef  __cplusplus
 }
@@ -0,0 +1,360 @@
+#include "amoled_mem_bus.h"
+
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include <string.h>
+
+#define MEM_CMD_SWRESET  0x01
+#define MEM_CMD_CASET    0x2A
+#define MEM_CMD_RASET    0x2B
+#define MEM_CMD_RAMWR    0x2C
+#define MEM_CMD_MADCTL   0x36
+#define MEM_CMD_COLMOD   0x3A
+#define MEM_CMD_RAMWRC   0x3C
+
+#define MEM_MADCTL_MV    (1 << 5)
+#define MEM_MADCTL_MX    (1 << 6)
+#define MEM_MADCTL_MY    (1 << 7)
+
+
+/*
+Memory panel : emulates the panel GRAM with CASET / RASET / MADCTL / COLMOD and
+RAMWR / RAMWRC semantics, and counts commands and bytes. No hardware needed, it
+builds on the unix port for golden image tests and throughput benchmarks.
+*/
+
+
+// Registers after power on or SWRESET
+static void mem_panel_reset(amoled_mem_bus_obj_t *self)
+{
+    self->SC = 0;
+    self->EC = self->width - 1;
+    self->SR = 0;
+    self->ER = self->height - 1;
+    self->madctl = 0;
+    self->colmod = 0x55;
+    self->Bpp = 2;
+    self->col = 0;
+    self->row = 0;
+    self->partial_len = 0;
+}
+
+
+// Store one pixel at the write pointer, then move the pointer like the panel does
+static void mem_panel_put(amoled_mem_bus_obj_t *self, const uint8_t *pixel)
+{
+    bool mv = self->madctl & MEM_MADCTL_MV;
+    int x = self->col;
+    int y = self->row;
+
+    // columns / rows are mirrored in the logical orientation, then swapped if MV is set
+    if (self->madctl & MEM_MADCTL_MX) {
+        x = (mv ? self->height : self->width) - 1 - x;
+    }
+    if (self->madctl & MEM_MADCTL_MY) {
+        y = (mv ? self->width : self->height) - 1 - y;
+    }
+    if (mv) {
+        int t = x;
+        x = y;
+        y = t;
+    }
+
+    if ((x >= 0) && (y >= 0) && (x < self->width) && (y < self->height)) {
+        memcpy(&self->gram[(y * self->width + x) * 3], pixel, self->Bpp);
+        self->pixels++;
+    } else {
+        self->clipped++;
+    }
+
+    // next column, then next row, and back to the window start after the last pixel
+    if (self->col++ >= self->EC) {
+        self->col = self->SC;
+        if (self->row++ >= self->ER) {
+            self->row = self->SR;
+        }
+    }
+}
+
+
+static void mem_panel_write(amoled_mem_bus_obj_t *self, int lcd_cmd, const uint8_t *color, size_t color_size)
+{
+    if (lcd_cmd != MEM_CMD_RAMWRC) {
+        self->col = self->SC;
+        self->row = self->SR;
+        self->partial_len = 0;
+    }
+    while (color_size--) {
+        self->partial[self->partial_len++] = *color++;
+        if (self->partial_len == self->Bpp) {
+            mem_panel_put(self, self->partial);
+            self->partial_len = 0;
+        }
+    }
+}
+
+
+static void hal_lcd_mem_panel_tx_param(mp_obj_base_t *self_in, int lcd_cmd, const void *param, size_t param_size)
+{
+    amoled_mem_bus_obj_t *self = (amoled_mem_bus_obj_t *)self_in;
+    const uint8_t *p = (const uint8_t *)param;
+
+    self->params++;
+    self->param_bytes += param_size;
+    self->cmd_count[lcd_cmd & 0xFF]++;
+
+    switch (lcd_cmd) {
+        case MEM_CMD_SWRESET:
+            mem_panel_reset(self);
+        break;
+
+        case MEM_CMD_CASET:
+            if (param_size >= 4) {
+                self->SC = (p[0] << 8) | p[1];
+                self->EC = (p[2] << 8) | p[3];
+            }
+        break;
+
+        case MEM_CMD_RASET:
+            if (param_size >= 4) {
+                self->SR = (p[0] << 8) | p[1];
+                self->ER = (p[2] << 8) | p[3];
+            }
+        break;
+
+        case MEM_CMD_MADCTL:
+            if (param_size >= 1) {
+                self->madctl = p[0];
+            }
+        break;
+
+        case MEM_CMD_COLMOD:
+            if (param_size >= 1) {
+                self->colmod = p[0];
+                self->Bpp = ((p[0] & 0x07) == 0x05) ? 2 : 3;
+            }
+        break;
+
+        case MEM_CMD_RAMWR:
+        case MEM_CMD_RAMWRC:
+            mem_panel_write(self, lcd_cmd, p, param_size);
+        break;
+    }
+}
+
+
+static void hal_lcd_mem_panel_tx_color(mp_obj_base_t *self_in, int lcd_cmd, const void *color, size_t color_size)
+{
+    amoled_mem_bus_obj_t *self = (amoled_mem_bus_obj_t *)self_in;
+
+    if (lcd_cmd == 0) {
+        lcd_cmd = MEM_CMD_RAMWR;
+    }
+    self->colors++;
+    self->color_bytes += color_size;
+    self->cmd_count[lcd_cmd & 0xFF]++;
+    mem_panel_write(self, lcd_cmd, (const uint8_t *)color, color_size);
+}
+
+
+static void hal_lcd_mem_panel_deinit(mp_obj_base_t *self_in)
+{
+}
+
+
+static void amoled_mem_bus_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    (void) kind;
+    amoled_mem_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(
+        print,
+        "<Mem Panel width=%u, height=%u, madctl=0x%02x, colmod=0x%02x>",
+        self->width,
+        self->height,
+        self->madctl,
+        self->colmod
+    );
+}
+
+
+static mp_obj_t amoled_mem_bus_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum {
+        ARG_width,
+        ARG_height
+    };
+    const mp_arg_t make_new_args[] = {
+        { MP_QSTR_width,            MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 240        } },
+        { MP_QSTR_height,           MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 240        } },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(make_new_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(make_new_args), make_new_args, args);
+
+    if ((args[ARG_width].u_int <= 0) || (args[ARG_height].u_int <= 0)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("width and height must be positive"));
+    }
+
+    // create new object
+    amoled_mem_bus_obj_t *self = m_new_obj(amoled_mem_bus_obj_t);
+    memset(self, 0, sizeof(*self));
+    self->base.type = &amoled_mem_bus_type;
+    self->width     = args[ARG_width].u_int;
+    self->height    = args[ARG_height].u_int;
+    self->gram      = m_new0(uint8_t, self->width * self->height * 3);
+    mem_panel_reset(self);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+
+// Raw GRAM content, 3 bytes per pixel, only the first Bpp bytes of each pixel are written
+static mp_obj_t amoled_mem_bus_gram(mp_obj_t self_in)
+{
+    amoled_mem_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bytearray_by_ref(self->width * self->height * 3, self->gram);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mem_bus_gram_obj, amoled_mem_bus_gram);
+
+
+// Pixel value as sent on the bus (first byte is the most significant)
+static mp_obj_t amoled_mem_bus_pixel(mp_obj_t self_in, mp_obj_t x_in, mp_obj_t y_in)
+{
+    amoled_mem_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_int_t x = mp_obj_get_int(x_in);
+    mp_int_t y = mp_obj_get_int(y_in);
+
+    if ((x < 0) || (y < 0) || (x >= self->width) || (y >= self->height)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("pixel out of GRAM"));
+    }
+    const uint8_t *p = &self->gram[(y * self->width + x) * 3];
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < self->Bpp; i++) {
+        value = (value << 8) | p[i];
+    }
+    return mp_obj_new_int_from_uint(value);
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(amoled_mem_bus_pixel_obj, amoled_mem_bus_pixel);
+
+
+// Clear GRAM to 0
+static mp_obj_t amoled_mem_bus_clear(mp_obj_t self_in)
+{
+    amoled_mem_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    memset(self->gram, 0, self->width * self->height * 3);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mem_bus_clear_obj, amoled_mem_bus_clear);
+
+
+// registers() -> (SC, EC, SR, ER, madctl, colmod)
+static mp_obj_t amoled_mem_bus_registers(mp_obj_t self_in)
+{
+    amoled_mem_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t regs[6] = {
+        mp_obj_new_int(self->SC),
+        mp_obj_new_int(self->EC),
+        mp_obj_new_int(self->SR),
+        mp_obj_new_int(self->ER),
+        mp_obj_new_int(self->madctl),
+        mp_obj_new_int(self->colmod)
+    };
+    return mp_obj_new_tuple(6, regs);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mem_bus_registers_obj, amoled_mem_bus_registers);
+
+
+// stats() -> (params, colors, param_bytes, color_bytes, pixels, clipped)
+static mp_obj_t amoled_mem_bus_stats(mp_obj_t self_in)
+{
+    amoled_mem_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t stats[6] = {
+        mp_obj_new_int_from_uint(self->params),
+        mp_obj_new_int_from_uint(self->colors),
+        mp_obj_new_int_from_uint(self->param_bytes),
+        mp_obj_new_int_from_uint(self->color_bytes),
+        mp_obj_new_int_from_uint(self->pixels),
+        mp_obj_new_int_from_uint(self->clipped)
+    };
+    return mp_obj_new_tuple(6, stats);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mem_bus_stats_obj, amoled_mem_bus_stats);
+
+
+// Number of times a command was sent (RAMWR / RAMWRC included)
+static mp_obj_t amoled_mem_bus_cmd_count(mp_obj_t self_in, mp_obj_t cmd_in)
+{
+    amoled_mem_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int_from_uint(self->cmd_count[mp_obj_get_int(cmd_in) & 0xFF]);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(amoled_mem_bus_cmd_count_obj, amoled_mem_bus_cmd_count);
+
+
+static mp_obj_t amoled_mem_bus_reset_stats(mp_obj_t self_in)
+{
+    amoled_mem_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    self->params      = 0;
+    self->colors      = 0;
+    self->param_bytes = 0;
+    self->color_bytes = 0;
+    self->pixels      = 0;
+    self->clipped     = 0;
+    memset(self->cmd_count, 0, sizeof(self->cmd_count));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mem_bus_reset_stats_obj, amoled_mem_bus_reset_stats);
+
+
+static mp_obj_t amoled_mem_bus_deinit(mp_obj_t self_in)
+{
+    hal_lcd_mem_panel_deinit((mp_obj_base_t *)MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mem_bus_deinit_obj, amoled_mem_bus_deinit);
+
+
+static const mp_rom_map_elem_t amoled_mem_bus_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_gram),        MP_ROM_PTR(&amoled_mem_bus_gram_obj)        },
+    { MP_ROM_QSTR(MP_QSTR_pixel),       MP_ROM_PTR(&amoled_mem_bus_pixel_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_clear),       MP_ROM_PTR(&amoled_mem_bus_clear_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_registers),   MP_ROM_PTR(&amoled_mem_bus_registers_obj)   },
+    { MP_ROM_QSTR(MP_QSTR_stats),       MP_ROM_PTR(&amoled_mem_bus_stats_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_cmd_count),   MP_ROM_PTR(&amoled_mem_bus_cmd_count_obj)   },
+    { MP_ROM_QSTR(MP_QSTR_reset_stats), MP_ROM_PTR(&amoled_mem_bus_reset_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_deinit),      MP_ROM_PTR(&amoled_mem_bus_deinit_obj)      },
+    { MP_ROM_QSTR(MP_QSTR___del__),     MP_ROM_PTR(&amoled_mem_bus_deinit_obj)      },
+};
+static MP_DEFINE_CONST_DICT(amoled_mem_bus_locals_dict, amoled_mem_bus_locals_dict_table);
+
+
+static const amoled_panel_p_t mp_lcd_mem_panel_p = {
+    .tx_param = hal_lcd_mem_panel_tx_param,
+    .tx_color = hal_lcd_mem_panel_tx_color,
+    .deinit = hal_lcd_mem_panel_deinit,
+    .wait = NULL,
+    .tx_window = NULL,
+    .error = NULL
+};
+
+
+#ifdef MP_OBJ_TYPE_GET_SLOT
+MP_DEFINE_CONST_OBJ_TYPE(
+    amoled_mem_bus_type,
+    MP_QSTR_MemPanel,
+    MP_TYPE_FLAG_NONE,
+    print, amoled_mem_bus_print,
+    make_new, amoled_mem_bus_make_new,
+    protocol, &mp_lcd_mem_panel_p,
+    locals_dict, (mp_obj_dict_t *)&amoled_mem_bus_locals_dict
+);
+#else
+const mp_obj_type_t amoled_mem_bus_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_MemPanel,
+    .print = amoled_mem_bus_print,
+    .make_new = amoled_mem_bus_make_new,
+    .protocol = &mp_lcd_mem_panel_p,
+    .locals_dict = (mp_obj_dict_t *)&amoled_mem_bus_locals_dict,
+};
+#endif
@@ -0,0 +1,38 @@
+#ifndef __amoled_mem_bus_H__
+#define __amoled_mem_bus_H__
+
+#include "py/obj.h"
+#include "amoled_panel.h"
+
+typedef struct _amoled_mem_bus_obj_t {
+    mp_obj_base_t base;
+    uint16_t width;                     // GRAM width (native orientation)
+    uint16_t height;                    // GRAM height (native orientation)
+    uint8_t *gram;                      // width x height pixels of 3 bytes max
+
+    // Emulated registers
+    uint16_t SC, EC;                    // CASET
+    uint16_t SR, ER;                    // RASET
+    uint8_t madctl;                     // MADCTL : MY, MX, MV are emulated
+    uint8_t colmod;                     // COLMOD : 0x55 => 2 bytes per pixel, else 3
+    uint8_t Bpp;                        // bytes per pixel from COLMOD
+
+    // Memory write pointer inside the window
+    uint16_t col;
+    uint16_t row;
+    uint8_t partial[3];                 // pixel bytes split between two transfers
+    uint8_t partial_len;
+
+    // Statistics
+    uint32_t params;                    // tx_param calls
+    uint32_t colors;                    // tx_color calls
+    uint32_t param_bytes;               // parameter bytes
+    uint32_t color_bytes;               // color bytes
+    uint32_t pixels;                    // pixels written in GRAM
+    uint32_t clipped;                   // pixels falling outside of GRAM
+    uint32_t cmd_count[256];            // calls per command
+} amoled_mem_bus_obj_t;
+
+extern const mp_obj_type_t amoled_mem_bus_type;
+
+#endif
@@ -0,0 +1,307 @@
+#include "amoled_mock_bus.h"
+
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include <string.h>
+
+#define MOCK_CHUNK_SIZE  0x8000  // 32kb, same split as the QSPI bus
+
+
+/*
+Mock bus : same protocol and queue semantics as QSPI_Panel, without hardware.
+Transactions stay in flight until complete() or wait() is called, so the
+async behaviour can be checked on the unix port.
+*/
+
+
+// Finish the oldest in-flight transaction
+static void mock_complete_one(amoled_mock_bus_obj_t *self)
+{
+    amoled_mock_trans_t *t = &self->trans[self->head];
+
+    // color data is read now, like a DMA would do : a buffer reused too early shows up in the checksum
+    if (t->buf) {
+        for (size_t i = 0; i < t->len; i++) {
+            self->checksum += t->buf[i];
+        }
+    }
+    if (t->last && (self->callback != mp_const_none)) {
+        mp_sched_schedule(self->callback, MP_OBJ_FROM_PTR(self));
+    }
+    self->head = (self->head + 1) % self->queue_depth;
+    self->queued--;
+}
+
+
+static void mock_queue(amoled_mock_bus_obj_t *self, const uint8_t *buf, size_t len, bool last)
+{
+    self->transactions++;
+
+    if (self->queue_depth == 0) {
+        for (size_t i = 0; buf && (i < len); i++) {
+            self->checksum += buf[i];
+        }
+        return;
+    }
+    if (self->queued >= self->queue_depth) {
+        self->stalls++;             // the real bus would block here
+        mock_complete_one(self);
+    }
+    amoled_mock_trans_t *t = &self->trans[(self->head + self->queued) % self->queue_depth];
+    t->buf  = buf;
+    t->len  = len;
+    t->last = last;
+    self->queued++;
+    if (self->queued > self->max_queued) {
+        self->max_queued = self->queued;
+    }
+}
+
+
+static void hal_lcd_mock_panel_wait(mp_obj_base_t *self_in)
+{
+    amoled_mock_bus_obj_t *self = (amoled_mock_bus_obj_t *)self_in;
+
+    while (self->queued > 0) {
+        mock_complete_one(self);
+    }
+}
+
+
+static void hal_lcd_mock_panel_tx_param(mp_obj_base_t *self_in, int lcd_cmd, const void *param, size_t param_size)
+{
+    amoled_mock_bus_obj_t *self = (amoled_mock_bus_obj_t *)self_in;
+
+    hal_lcd_mock_panel_wait(self_in);       // same rule as QSPI : no command while colors are queued
+    self->params++;
+    self->transactions++;
+}
+
+
+static void mock_send_color(amoled_mock_bus_obj_t *self, const void *color, size_t color_size)
+{
+    const uint8_t *p_color = (const uint8_t *)color;
+    size_t len = color_size;
+    size_t chunk_size;
+
+    self->colors++;
+    self->color_bytes += color_size;
+
+    mock_queue(self, NULL, 0, false);       // RAMWR header
+    do {
+        chunk_size = (len > MOCK_CHUNK_SIZE) ? MOCK_CHUNK_SIZE : len;
+        len -= chunk_size;
+        mock_queue(self, p_color, chunk_size, (len == 0));
+        p_color += chunk_size;
+    } while (len > 0);
+}
+
+
+static void hal_lcd_mock_panel_tx_color(mp_obj_base_t *self_in, int lcd_cmd, const void *color, size_t color_size)
+{
+    hal_lcd_mock_panel_wait(self_in);
+    mock_send_color((amoled_mock_bus_obj_t *)self_in, color, color_size);
+}
+
+
+static void hal_lcd_mock_panel_tx_window(mp_obj_base_t *self_in, const uint8_t *caset, const uint8_t *raset, int lcd_cmd, const void *color, size_t color_size)
+{
+    amoled_mock_bus_obj_t *self = (amoled_mock_bus_obj_t *)self_in;
+
+    hal_lcd_mock_panel_wait(self_in);
+    if (caset) {
+        self->params++;
+        self->transactions++;
+    }
+    if (raset) {
+        self->params++;
+        self->transactions++;
+    }
+    mock_send_color(self, color, color_size);
+}
+
+
+static void hal_lcd_mock_panel_deinit(mp_obj_base_t *self_in)
+{
+    hal_lcd_mock_panel_wait(self_in);
+}
+
+
+static void amoled_mock_bus_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind)
+{
+    (void) kind;
+    amoled_mock_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(
+        print,
+        "<Mock Panel width=%u, height=%u, queue_depth=%u>",
+        self->width,
+        self->height,
+        self->queue_depth
+    );
+}
+
+
+static mp_obj_t amoled_mock_bus_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args)
+{
+    enum {
+        ARG_width,
+        ARG_height,
+        ARG_queue_depth,
+        ARG_callback
+    };
+    const mp_arg_t make_new_args[] = {
+        { MP_QSTR_width,            MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 240        } },
+        { MP_QSTR_height,           MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 240        } },
+        { MP_QSTR_queue_depth,      MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 0          } },
+        { MP_QSTR_callback,         MP_ARG_OBJ | MP_ARG_KW_ONLY,  {.u_obj = mp_const_none} },
+    };
+    mp_arg_val_t args[MP_ARRAY_SIZE(make_new_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(make_new_args), make_new_args, args);
+
+    if ((args[ARG_queue_depth].u_int < 0) || (args[ARG_queue_depth].u_int > AMOLED_QUEUE_MAX_DEPTH)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("queue_depth out of range"));
+    }
+
+    // create new object
+    amoled_mock_bus_obj_t *self = m_new_obj(amoled_mock_bus_obj_t);
+    memset(self, 0, sizeof(*self));
+    self->base.type   = &amoled_mock_bus_type;
+    self->width       = args[ARG_width].u_int;
+    self->height      = args[ARG_height].u_int;
+    self->queue_depth = args[ARG_queue_depth].u_int;
+    self->callback    = args[ARG_callback].u_obj;
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+
+// Simulate the hardware finishing n (default 1) in-flight transactions
+static mp_obj_t amoled_mock_bus_complete(size_t n_args, const mp_obj_t *args_in)
+{
+    amoled_mock_bus_obj_t *self = MP_OBJ_TO_PTR(args_in[0]);
+    mp_int_t n = (n_args > 1) ? mp_obj_get_int(args_in[1]) : 1;
+
+    while ((n-- > 0) && (self->queued > 0)) {
+        mock_complete_one(self);
+    }
+    return mp_obj_new_int(self->queued);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_mock_bus_complete_obj, 1, 2, amoled_mock_bus_complete);
+
+
+static mp_obj_t amoled_mock_bus_wait(mp_obj_t self_in)
+{
+    hal_lcd_mock_panel_wait((mp_obj_base_t *)MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mock_bus_wait_obj, amoled_mock_bus_wait);
+
+
+static mp_obj_t amoled_mock_bus_busy(mp_obj_t self_in)
+{
+    amoled_mock_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(self->queued > 0);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mock_bus_busy_obj, amoled_mock_bus_busy);
+
+
+static mp_obj_t amoled_mock_bus_callback(mp_obj_t self_in, mp_obj_t callback_in)
+{
+    amoled_mock_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if ((callback_in != mp_const_none) && !mp_obj_is_callable(callback_in)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("callback must be callable or None"));
+    }
+    self->callback = callback_in;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(amoled_mock_bus_callback_obj, amoled_mock_bus_callback);
+
+
+// stats() -> (params, colors, color_bytes, transactions, queued, max_queued, stalls, checksum)
+static mp_obj_t amoled_mock_bus_stats(mp_obj_t self_in)
+{
+    amoled_mock_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t stats[8] = {
+        mp_obj_new_int_from_uint(self->params),
+        mp_obj_new_int_from_uint(self->colors),
+        mp_obj_new_int_from_uint(self->color_bytes),
+        mp_obj_new_int_from_uint(self->transactions),
+        mp_obj_new_int(self->queued),
+        mp_obj_new_int(self->max_queued),
+        mp_obj_new_int_from_uint(self->stalls),
+        mp_obj_new_int_from_uint(self->checksum)
+    };
+    return mp_obj_new_tuple(8, stats);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mock_bus_stats_obj, amoled_mock_bus_stats);
+
+
+static mp_obj_t amoled_mock_bus_reset_stats(mp_obj_t self_in)
+{
+    amoled_mock_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    self->params       = 0;
+    self->colors       = 0;
+    self->color_bytes  = 0;
+    self->transactions = 0;
+    self->stalls       = 0;
+    self->max_queued   = self->queued;
+    self->checksum     = 0;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mock_bus_reset_stats_obj, amoled_mock_bus_reset_stats);
+
+
+static mp_obj_t amoled_mock_bus_deinit(mp_obj_t self_in)
+{
+    hal_lcd_mock_panel_deinit((mp_obj_base_t *)MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_mock_bus_deinit_obj, amoled_mock_bus_deinit);
+
+
+static const mp_rom_map_elem_t amoled_mock_bus_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_complete),    MP_ROM_PTR(&amoled_mock_bus_complete_obj)    },
+    { MP_ROM_QSTR(MP_QSTR_wait),        MP_ROM_PTR(&amoled_mock_bus_wait_obj)        },
+    { MP_ROM_QSTR(MP_QSTR_busy),        MP_ROM_PTR(&amoled_mock_bus_busy_obj)        },
+    { MP_ROM_QSTR(MP_QSTR_callback),    MP_ROM_PTR(&amoled_mock_bus_callback_obj)    },
+    { MP_ROM_QSTR(MP_QSTR_stats),       MP_ROM_PTR(&amoled_mock_bus_stats_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_reset_stats), MP_ROM_PTR(&amoled_mock_bus_reset_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_deinit),      MP_ROM_PTR(&amoled_mock_bus_deinit_obj)      },
+    { MP_ROM_QSTR(MP_QSTR___del__),     MP_ROM_PTR(&amoled_mock_bus_deinit_obj)      },
+};
+static MP_DEFINE_CONST_DICT(amoled_mock_bus_locals_dict, amoled_mock_bus_locals_dict_table);
+
+
+static const amoled_panel_p_t mp_lcd_mock_panel_p = {
+    .tx_param = hal_lcd_mock_panel_tx_param,
+    .tx_color = hal_lcd_mock_panel_tx_color,
+    .deinit = hal_lcd_mock_panel_deinit,
+    .wait = hal_lcd_mock_panel_wait,
+    .tx_window = hal_lcd_mock_panel_tx_window,
+    .error = NULL
+};
+
+
+#ifdef MP_OBJ_TYPE_GET_SLOT
+MP_DEFINE_CONST_OBJ_TYPE(
+    amoled_mock_bus_type,
+    MP_QSTR_MockPanel,
+    MP_TYPE_FLAG_NONE,
+    print, amoled_mock_bus_print,
+    make_new, amoled_mock_bus_make_new,
+    protocol, &mp_lcd_mock_panel_p,
+    locals_dict, (mp_obj_dict_t *)&amoled_mock_bus_locals_dict
+);
+#else
+const mp_obj_type_t amoled_mock_bus_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_MockPanel,
+    .print = amoled_mock_bus_print,
+    .make_new = amoled_mock_bus_make_new,
+    .protocol = &mp_lcd_mock_panel_p,
+    .locals_dict = (mp_obj_dict_t *)&amoled_mock_bus_locals_dict,
+};
+#endif
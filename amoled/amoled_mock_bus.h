@@ -0,0 +1,38 @@
+#ifndef __amoled_mock_bus_H__
+#define __amoled_mock_bus_H__
+
+#include "py/obj.h"
+#include "amoled_panel.h"
+
+// One simulated SPI transaction waiting in the mock queue
+typedef struct _amoled_mock_trans_t {
+    const uint8_t *buf;                 // color data, read when the transaction completes (NULL for RAMWR header)
+    size_t len;                         // bytes
+    bool last;                          // last transaction of a color transfer
+} amoled_mock_trans_t;
+
+typedef struct _amoled_mock_bus_obj_t {
+    mp_obj_base_t base;
+    uint16_t width;
+    uint16_t height;
+
+    // Queue emulation, queue_depth = 0 completes every transaction immediately
+    uint8_t queue_depth;
+    uint8_t queued;                     // in-flight transactions
+    uint8_t head;                       // oldest in-flight transaction in ring
+    amoled_mock_trans_t trans[AMOLED_QUEUE_MAX_DEPTH];
+    mp_obj_t callback;                  // scheduled when a color transfer completes
+
+    // Statistics
+    uint32_t params;                    // tx_param calls
+    uint32_t colors;                    // tx_color calls
+    uint32_t color_bytes;               // color bytes sent
+    uint32_t transactions;              // simulated SPI transactions
+    uint32_t stalls;                    // queue full, oldest transaction forced to complete
+    uint8_t  max_queued;                // highest in-flight count seen
+    uint32_t checksum;                  // sum of color bytes, read at completion time
+} amoled_mock_bus_obj_t;
+
+extern const mp_obj_type_t amoled_mock_bus_type;
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef __amoled_panel_H__
+#define __amoled_panel_H__
+
+#include "py/obj.h"
+
+// Panel protocol : the only link between the graphic core and a bus object (QSPI_Panel, MockPanel...)
+typedef struct _amoled_panel_p_t {
+    void (*tx_param)(mp_obj_base_t *self, int lcd_cmd, const void *param, size_t param_size);
+    void (*tx_color)(mp_obj_base_t *self, int lcd_cmd, const void *color, size_t color_size);
+    void (*deinit)(mp_obj_base_t *self);
+    void (*wait)(mp_obj_base_t *self);   // Block until queued color transfers are done (NULL if bus is always blocking)
+    // CASET and RASET (each skipped when NULL, 4 bytes) then lcd_cmd (RAMWR or RAMWRC) with colors in one call (NULL if not supported)
+    void (*tx_window)(mp_obj_base_t *self, const uint8_t *caset, const uint8_t *raset, int lcd_cmd, const void *color, size_t color_size);
+    // First failed transfer since the last call, then cleared (0 if none, NULL if the bus can't fail).
+    // Transfers may run on the present worker where nothing can be raised, the graphic core raises it.
+    int (*error)(mp_obj_base_t *self);
+} amoled_panel_p_t;
+
+#define AMOLED_QUEUE_MAX_DEPTH  8        // Max in-flight color transactions for asynchronous buses
+
+#endif
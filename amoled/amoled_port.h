@@ -0,0 +1,200 @@
+#ifndef __amoled_port_H__
+#define __amoled_port_H__
+
+/*
+Platform glue : ESP-IDF on the boards, plain libc elsewhere (MicroPython unix port).
+Off target only the MemPanel and MockPanel buses are available.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <wchar.h>
+
+#ifdef ESP_PLATFORM
+
+#include "esp_heap_caps.h"
+
+#else
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT      0
+#define MALLOC_CAP_32BIT     0
+#define MALLOC_CAP_DMA       0
+#define MALLOC_CAP_INTERNAL  0
+#define MALLOC_CAP_SPIRAM    0
+
+// Alignment is only needed by the DMA, malloc alignment is enough on a host
+#define heap_caps_malloc(size, caps)                            malloc(size)
+#define heap_caps_calloc(n, size, caps)                         calloc(n, size)
+#define heap_caps_aligned_alloc(align, size, caps)              malloc(size)
+#define heap_caps_aligned_calloc(align, n, size, caps)          calloc(n, size)
+#define heap_caps_free(ptr)                                     free(ptr)
+
+#endif
+
+/*
+Pixel kernels : every primitive and the refresh path go through them, they stay bit exact whatever
+the target. 2 pixels are handled per 32 bits word where it pays, memcpy keeps the word accesses legal
+for the compiler (it is turned into plain loads and stores).
+*/
+
+// Fill n 16 bits pixels, wmemset only fits when wchar_t is 16 bits (ESP32 toolchains)
+static inline void amoled_fill16(uint16_t *dst, uint16_t color, size_t n) {
+#if WCHAR_MAX == 0xFFFF
+    wmemset((wchar_t *)dst, color, n);
+#else
+    uint32_t w[4];
+    w[0] = w[1] = w[2] = w[3] = color | ((uint32_t)color << 16);
+    if (n && ((uintptr_t)dst & 2)) {
+        *dst++ = color;
+        n--;
+    }
+    for (; n >= 8; n -= 8) {
+        memcpy(dst, w, sizeof(w));
+        dst += 8;
+    }
+    while (n--) {
+        *dst++ = color;
+    }
+#endif
+}
+
+// Copy n 16 bits pixels, areas must not overlap
+static inline void amoled_copy16(uint16_t *dst, const uint16_t *src, size_t n) {
+    memcpy(dst, src, n * sizeof(uint16_t));
+}
+
+#define AMOLED_SWAP16(c)    ((uint16_t)(((c) >> 8) | ((c) << 8)))
+
+// Copy n 16 bits pixels swapping their bytes, 2 pixels per 32 bits word and 8 pixels per loop
+static inline void amoled_copy_swap16(uint16_t *dst, const uint16_t *src, size_t n) {
+    uint32_t w[4];
+    for (; n >= 8; n -= 8) {
+        memcpy(w, src, sizeof(w));
+        w[0] = ((w[0] & 0x00FF00FF) << 8) | ((w[0] >> 8) & 0x00FF00FF);
+        w[1] = ((w[1] & 0x00FF00FF) << 8) | ((w[1] >> 8) & 0x00FF00FF);
+        w[2] = ((w[2] & 0x00FF00FF) << 8) | ((w[2] >> 8) & 0x00FF00FF);
+        w[3] = ((w[3] & 0x00FF00FF) << 8) | ((w[3] >> 8) & 0x00FF00FF);
+        memcpy(dst, w, sizeof(w));
+        dst += 8;
+        src += 8;
+    }
+    while (n--) {
+        *dst++ = AMOLED_SWAP16(*src);
+        src++;
+    }
+}
+
+// Expand n 8 bits palette indices to 16 bits colors through lut, 4 pixels per loop
+static inline void amoled_expand8(uint16_t *dst, const uint8_t *src, const uint16_t *lut, size_t n) {
+    for (; n >= 4; n -= 4) {
+        dst[0] = lut[src[0]];
+        dst[1] = lut[src[1]];
+        dst[2] = lut[src[2]];
+        dst[3] = lut[src[3]];
+        dst += 4;
+        src += 4;
+    }
+    while (n--) {
+        *dst++ = lut[*src++];
+    }
+}
+
+// Expand n 1, 2 or 4 bits palette indices packed from bit (first pixel in the high bits of a byte)
+static inline void amoled_expand_bits(uint16_t *dst, const uint8_t *src, size_t bit, uint8_t bpp, const uint16_t *lut, size_t n) {
+    uint8_t mask = (1 << bpp) - 1;
+    uint8_t shift = 8 - (bit & 7);
+    uint8_t byte;
+
+    src += bit >> 3;
+    byte = *src++;
+    while (n--) {
+        if (shift == 0) {
+            byte = *src++;
+            shift = 8;
+        }
+        shift -= bpp;
+        *dst++ = lut[(byte >> shift) & mask];
+    }
+}
+
+// Expand n bits of a 1 bit bitmap from bit (first pixel in the high bit of a byte) to 16 bits pixels,
+// 0 bits are left alone unless bg_filled. Whole set or clear bytes are filled 8 pixels at once.
+static inline void amoled_expand1(uint16_t *dst, const uint8_t *src, size_t bit, uint16_t fg, uint16_t bg, bool bg_filled, size_t n) {
+    uint8_t byte;
+
+    src += bit >> 3;
+    bit &= 7;
+    while (n) {
+        byte = *src++;
+        if ((bit == 0) && (n >= 8) && ((byte == 0xFF) || ((byte == 0x00) && bg_filled))) {
+            amoled_fill16(dst, byte ? fg : bg, 8);
+            dst += 8;
+            n -= 8;
+            continue;
+        }
+        for (uint8_t mask = 0x80 >> bit; mask && n; mask >>= 1, n--, dst++) {
+            if (byte & mask) {
+                *dst = fg;
+            } else if (bg_filled) {
+                *dst = bg;
+            }
+        }
+        bit = 0;
+    }
+}
+
+// Blend fg over n RGB565 pixels with 8 bits alpha (0 keeps the pixel, 255 gives fg).
+// Green and red / blue are spread in one word so both products are done at once, with 5 bits of alpha.
+// swap is true when pixels are stored byte swapped (bus order), fg is then given byte swapped too.
+static inline void amoled_blend_alpha8(uint16_t *dst, const uint8_t *alpha, uint16_t fg, bool swap, size_t n) {
+    uint16_t fg_n = swap ? AMOLED_SWAP16(fg) : fg;
+    uint32_t fg_w = (fg_n | ((uint32_t)fg_n << 16)) & 0x07E0F81F;
+
+    for (; n; n--, dst++) {
+        uint8_t a = *alpha++;
+        if (a == 0) {
+            continue;
+        }
+        if (a == 255) {
+            *dst = fg;
+            continue;
+        }
+        uint16_t bg_n = swap ? AMOLED_SWAP16(*dst) : *dst;
+        uint32_t bg_w = (bg_n | ((uint32_t)bg_n << 16)) & 0x07E0F81F;
+        uint32_t w = (bg_w + (((fg_w - bg_w) * ((a + 4) >> 3)) >> 5)) & 0x07E0F81F;
+        uint16_t c = w | (w >> 16);
+        *dst = swap ? AMOLED_SWAP16(c) : c;
+    }
+}
+
+// Set nbits bits from bit to the same bits of pattern, whole bytes with memset, masks for the ends
+static inline void amoled_fill_bits(uint8_t *buf, size_t bit, size_t nbits, uint8_t pattern) {
+    uint8_t mask;
+
+    buf += bit >> 3;
+    bit &= 7;
+    if (bit) {
+        mask = 0xFF >> bit;
+        if (bit + nbits < 8) {
+            mask &= ~(0xFF >> (bit + nbits));
+        }
+        *buf = (*buf & ~mask) | (pattern & mask);
+        if (bit + nbits <= 8) {
+            return;
+        }
+        nbits -= 8 - bit;
+        buf++;
+    }
+    memset(buf, pattern, nbits >> 3);
+    buf += nbits >> 3;
+    if (nbits & 7) {
+        mask = ~(0xFF >> (nbits & 7));
+        *buf = (*buf & ~mask) | (pattern & mask);
+    }
+}
+
+#endif
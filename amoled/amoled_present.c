@@ -0,0 +1,185 @@
+#include "amoled_present.h"
+
+#include "py/runtime.h"
+#include "py/mpthread.h"
+#include "mphalport.h"
+
+
+/*
+Present worker : the double buffer mode hands the front buffer to this worker, which streams it
+to the panel while MicroPython draws in the back buffer. kick() starts one run, wait() blocks
+until it is over (the GIL is released meanwhile).
+*/
+
+
+#ifdef ESP_PLATFORM
+
+// MicroPython runs on MP_TASK_COREID, the worker takes the other core when there is one
+#if defined(MP_TASK_COREID) && !CONFIG_FREERTOS_UNICORE
+#define PRESENT_TASK_COREID    (MP_TASK_COREID ^ 1)
+#else
+#define PRESENT_TASK_COREID    (0)
+#endif
+
+static void present_task(void *arg)
+{
+    amoled_present_t *p = (amoled_present_t *)arg;
+
+    for (;;) {
+        xSemaphoreTake(p->go, portMAX_DELAY);
+        if (p->stop) {
+            break;
+        }
+        p->run(p->arg);
+        p->busy = false;
+        xSemaphoreGive(p->done);
+    }
+    xSemaphoreGive(p->done);
+    vTaskDelete(NULL);
+}
+
+
+bool amoled_present_start(amoled_present_t *p, void (*run)(void *arg), void *arg)
+{
+    p->run = run;
+    p->arg = arg;
+    p->busy = false;
+    p->stop = false;
+    p->go = xSemaphoreCreateBinary();
+    p->done = xSemaphoreCreateBinary();
+    if ((p->go == NULL) || (p->done == NULL) ||
+        (xTaskCreatePinnedToCore(present_task, "amoled_present", PRESENT_TASK_STACK, p,
+                                 PRESENT_TASK_PRIORITY, &p->task, PRESENT_TASK_COREID) != pdPASS)) {
+        if (p->go) vSemaphoreDelete(p->go);
+        if (p->done) vSemaphoreDelete(p->done);
+        return false;
+    }
+    p->started = true;
+    return true;
+}
+
+
+void amoled_present_kick(amoled_present_t *p)
+{
+    p->busy = true;
+    xSemaphoreGive(p->go);
+}
+
+
+void amoled_present_wait(amoled_present_t *p)
+{
+    if (!p->started) {
+        return;
+    }
+    MP_THREAD_GIL_EXIT();
+    while (p->busy) {       // done may hold a give left by a run nobody waited for
+        xSemaphoreTake(p->done, portMAX_DELAY);
+    }
+    MP_THREAD_GIL_ENTER();
+}
+
+
+void amoled_present_stop(amoled_present_t *p)
+{
+    if (!p->started) {
+        return;
+    }
+    amoled_present_wait(p);
+    xSemaphoreTake(p->done, 0);
+    p->stop = true;
+    xSemaphoreGive(p->go);
+    xSemaphoreTake(p->done, portMAX_DELAY);
+    vSemaphoreDelete(p->go);
+    vSemaphoreDelete(p->done);
+    p->started = false;
+}
+
+#else
+
+static void *present_thread(void *arg)
+{
+    amoled_present_t *p = (amoled_present_t *)arg;
+
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (!p->pending && !p->stop) {
+            pthread_cond_wait(&p->cond, &p->lock);
+        }
+        if (p->stop) {
+            break;
+        }
+        p->pending = false;
+        pthread_mutex_unlock(&p->lock);
+
+        p->run(p->arg);
+
+        pthread_mutex_lock(&p->lock);
+        p->busy = false;
+        pthread_cond_broadcast(&p->cond);
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+
+bool amoled_present_start(amoled_present_t *p, void (*run)(void *arg), void *arg)
+{
+    p->run = run;
+    p->arg = arg;
+    p->busy = false;
+    p->stop = false;
+    p->pending = false;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    if (pthread_create(&p->thread, NULL, present_thread, p) != 0) {
+        pthread_cond_destroy(&p->cond);
+        pthread_mutex_destroy(&p->lock);
+        return false;
+    }
+    p->started = true;
+    return true;
+}
+
+
+void amoled_present_kick(amoled_present_t *p)
+{
+    pthread_mutex_lock(&p->lock);
+    p->busy = true;
+    p->pending = true;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+
+void amoled_present_wait(amoled_present_t *p)
+{
+    if (!p->started) {
+        return;
+    }
+    MP_THREAD_GIL_EXIT();
+    pthread_mutex_lock(&p->lock);
+    while (p->busy) {
+        pthread_cond_wait(&p->cond, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+    MP_THREAD_GIL_ENTER();
+}
+
+
+void amoled_present_stop(amoled_present_t *p)
+{
+    if (!p->started) {
+        return;
+    }
+    amoled_present_wait(p);
+    pthread_mutex_lock(&p->lock);
+    p->stop = true;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->thread, NULL);
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    p->started = false;
+}
+
+#endif
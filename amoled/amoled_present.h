@@ -0,0 +1,43 @@
+#ifndef __amoled_present_H__
+#define __amoled_present_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#else
+#include <pthread.h>
+#endif
+
+#define PRESENT_TASK_STACK     (4096)
+#define PRESENT_TASK_PRIORITY  (2)       // above the MicroPython task so a frame is sent without delay
+
+// Background worker running one function at each kick : FreeRTOS task on the core MicroPython
+// does not use, pthread on a host (unix port)
+typedef struct _amoled_present_t {
+    void (*run)(void *arg);             // sends a frame
+    void *arg;
+    volatile bool busy;                 // kicked and not finished yet
+    volatile bool stop;                 // ask the worker to end
+    bool started;
+#ifdef ESP_PLATFORM
+    TaskHandle_t task;
+    SemaphoreHandle_t go;               // given by kick
+    SemaphoreHandle_t done;             // given when run returns
+#else
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool pending;                       // kicked, run not started yet
+#endif
+} amoled_present_t;
+
+bool amoled_present_start(amoled_present_t *p, void (*run)(void *arg), void *arg);
+void amoled_present_kick(amoled_present_t *p);
+void amoled_present_wait(amoled_present_t *p);
+void amoled_present_stop(amoled_present_t *p);
+
+#endif
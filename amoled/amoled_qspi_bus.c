@@ -6,6 +6,8 @@
 #include "esp_lcd_panel_ops.h"
 #include "soc/soc_caps.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
 
 #include "mphalport.h"
 #include "machine_hw_spi.c"
@@ -24,6 +26,158 @@
 Actual functions for qspi transmission.
 */
 
+
+// Add a transaction duration to the latency histogram, bucket i counts [2^i, 2^(i+1)) us
+static void IRAM_ATTR hal_lcd_qspi_panel_latency(amoled_qspi_bus_obj_t *qspi_panel_obj, uint32_t us)
+{
+    uint8_t bucket = 0;
+
+    while ((us > 1) && (bucket < AMOLED_LATENCY_BUCKETS - 1)) {
+        us >>= 1;
+        bucket++;
+    }
+    qspi_panel_obj->latency[bucket]++;
+}
+
+
+// Called by the SPI driver (ISR context) at the end of every transaction
+static void IRAM_ATTR hal_lcd_qspi_panel_post_cb(spi_transaction_t *t)
+{
+    amoled_qspi_bus_obj_t *qspi_panel_obj = (amoled_qspi_bus_obj_t *)t->user;
+
+    if (qspi_panel_obj == NULL) {
+        return;     // polling transaction, nothing to account
+    }
+    size_t slot = (spi_transaction_ext_t *)t - qspi_panel_obj->trans;
+    hal_lcd_qspi_panel_latency(qspi_panel_obj, (uint32_t)esp_timer_get_time() - qspi_panel_obj->trans_start[slot]);
+
+    qspi_panel_obj->completed++;
+    if ((t == qspi_panel_obj->last_trans) && (qspi_panel_obj->callback != mp_const_none)) {
+        mp_sched_schedule(qspi_panel_obj->callback, MP_OBJ_FROM_PTR(qspi_panel_obj));
+    }
+}
+
+
+// Software CS is only driven when the SPI peripheral doesn't do it
+static inline void hal_lcd_qspi_panel_cs_low(amoled_qspi_bus_obj_t *qspi_panel_obj)
+{
+    if (!qspi_panel_obj->hw_cs) {
+        mp_hal_pin_od_low(qspi_panel_obj->cs_pin);
+    }
+}
+
+static inline void hal_lcd_qspi_panel_cs_high(amoled_qspi_bus_obj_t *qspi_panel_obj)
+{
+    if (!qspi_panel_obj->hw_cs) {
+        mp_hal_pin_od_high(qspi_panel_obj->cs_pin);
+    }
+}
+
+
+// Hardware CS : keep the bus for the whole sequence (needed by SPI_TRANS_CS_KEEP_ACTIVE)
+static void hal_lcd_qspi_panel_acquire(amoled_qspi_bus_obj_t *qspi_panel_obj)
+{
+    machine_hw_spi_obj_t *spi_obj = ((machine_hw_spi_obj_t *)qspi_panel_obj->spi_obj);
+
+    if (qspi_panel_obj->hw_cs && !qspi_panel_obj->bus_acquired) {
+        spi_device_acquire_bus(spi_obj->spi, portMAX_DELAY);
+        qspi_panel_obj->bus_acquired = true;
+    }
+}
+
+static void hal_lcd_qspi_panel_release(amoled_qspi_bus_obj_t *qspi_panel_obj)
+{
+    machine_hw_spi_obj_t *spi_obj = ((machine_hw_spi_obj_t *)qspi_panel_obj->spi_obj);
+
+    if (qspi_panel_obj->bus_acquired) {
+        spi_device_release_bus(spi_obj->spi);
+        qspi_panel_obj->bus_acquired = false;
+    }
+}
+
+
+// Keep the first failure of the SPI driver, it is raised later by the graphic core (see error())
+static esp_err_t hal_lcd_qspi_panel_check(amoled_qspi_bus_obj_t *qspi_panel_obj, esp_err_t ret)
+{
+    if ((ret != ESP_OK) && (qspi_panel_obj->error == ESP_OK)) {
+        qspi_panel_obj->error = ret;
+    }
+    return ret;
+}
+
+
+// Blocking transaction, timed for the latency histogram
+static esp_err_t hal_lcd_qspi_panel_poll(amoled_qspi_bus_obj_t *qspi_panel_obj, spi_transaction_t *t)
+{
+    machine_hw_spi_obj_t *spi_obj = ((machine_hw_spi_obj_t *)qspi_panel_obj->spi_obj);
+    uint32_t start = (uint32_t)esp_timer_get_time();
+
+    esp_err_t ret = spi_device_polling_transmit(spi_obj->spi, t);
+    hal_lcd_qspi_panel_latency(qspi_panel_obj, (uint32_t)esp_timer_get_time() - start);
+    return hal_lcd_qspi_panel_check(qspi_panel_obj, ret);
+}
+
+
+// Get back one finished transaction from the driver queue (blocks until the oldest one is done)
+static void hal_lcd_qspi_panel_reclaim(amoled_qspi_bus_obj_t *qspi_panel_obj)
+{
+    machine_hw_spi_obj_t *spi_obj = ((machine_hw_spi_obj_t *)qspi_panel_obj->spi_obj);
+    spi_transaction_t *rt;
+
+    // without a result the slot will never come back, it is given up so nothing waits for it forever
+    hal_lcd_qspi_panel_check(qspi_panel_obj, spi_device_get_trans_result(spi_obj->spi, &rt, portMAX_DELAY));
+    qspi_panel_obj->queued--;
+}
+
+
+// Queue a transaction, with never more than queue_depth transactions in flight
+// last = true flags the end of a color transfer (completion callback)
+// A transaction the driver refused is not in flight and is not counted
+static esp_err_t hal_lcd_qspi_panel_queue(amoled_qspi_bus_obj_t *qspi_panel_obj, const spi_transaction_ext_t *t, bool last)
+{
+    machine_hw_spi_obj_t *spi_obj = ((machine_hw_spi_obj_t *)qspi_panel_obj->spi_obj);
+
+    if (qspi_panel_obj->queued >= qspi_panel_obj->queue_depth) {
+        hal_lcd_qspi_panel_reclaim(qspi_panel_obj);    // oldest slot is free again
+    }
+    // the ring slot is only reused once its transaction has been reclaimed
+    size_t slot_idx = qspi_panel_obj->issued % qspi_panel_obj->queue_depth;
+    spi_transaction_ext_t *slot = &qspi_panel_obj->trans[slot_idx];
+    *slot = *t;
+    slot->base.user = qspi_panel_obj;
+    if (last) {
+        qspi_panel_obj->last_trans = (spi_transaction_t *)slot;
+    }
+
+    qspi_panel_obj->trans_start[slot_idx] = (uint32_t)esp_timer_get_time();
+    esp_err_t ret = spi_device_queue_trans(spi_obj->spi, (spi_transaction_t *)slot, portMAX_DELAY);
+    if (ret != ESP_OK) {
+        if (last) {
+            qspi_panel_obj->last_trans = NULL;
+        }
+        return hal_lcd_qspi_panel_check(qspi_panel_obj, ret);
+    }
+    qspi_panel_obj->issued++;
+    qspi_panel_obj->queued++;
+    return ESP_OK;
+}
+
+
+// Wait for every queued transaction, then release CS and the bus
+static void hal_lcd_qspi_panel_wait(mp_obj_base_t *self)
+{
+    amoled_qspi_bus_obj_t *qspi_panel_obj = (amoled_qspi_bus_obj_t *)self;
+
+    while (qspi_panel_obj->queued > 0) {
+        hal_lcd_qspi_panel_reclaim(qspi_panel_obj);
+    }
+    if (qspi_panel_obj->cs_active) {
+        mp_hal_pin_od_high(qspi_panel_obj->cs_pin);
+        qspi_panel_obj->cs_active = false;
+    }
+    hal_lcd_qspi_panel_release(qspi_panel_obj);
+}
+
 void hal_lcd_qspi_panel_construct(mp_obj_base_t *self)
 {
     amoled_qspi_bus_obj_t *qspi_panel_obj = (amoled_qspi_bus_obj_t *)self;
@@ -34,8 +188,10 @@ void hal_lcd_qspi_panel_construct(mp_obj_base_t *self)
         machine_hw_spi_deinit_internal(&old_spi_obj);
     }
 
-    mp_hal_pin_output(qspi_panel_obj->cs_pin);
-    mp_hal_pin_od_high(qspi_panel_obj->cs_pin);
+    if (!qspi_panel_obj->hw_cs) {
+        mp_hal_pin_output(qspi_panel_obj->cs_pin);
+        mp_hal_pin_od_high(qspi_panel_obj->cs_pin);
+    }
 
     spi_bus_config_t buscfg = {
         .data0_io_num = qspi_panel_obj->databus_pins[0],
@@ -60,9 +216,10 @@ void hal_lcd_qspi_panel_construct(mp_obj_base_t *self)
         .address_bits = 24,     // Set but unusefull as SPI_TRANS_VARIABLE_ADDR will be specified fot transation
         .mode = spi_obj->phase | (spi_obj->polarity << 1),
         .clock_speed_hz = qspi_panel_obj->pclk,
-        .spics_io_num = -1,
+        .spics_io_num = qspi_panel_obj->hw_cs ? qspi_panel_obj->cs_pin : -1,
         .flags = SPI_DEVICE_HALFDUPLEX,
-        .queue_size = 10,
+        .queue_size = AMOLED_QUEUE_MAX_DEPTH + 2,
+        .post_cb = hal_lcd_qspi_panel_post_cb,
     };
 
     ret = spi_bus_add_device(spi_obj->host, &devcfg, &spi_obj->spi);
@@ -72,52 +229,87 @@ void hal_lcd_qspi_panel_construct(mp_obj_base_t *self)
 }
 
 
+// With hardware CS and a queue, short commands are queued behind the running transfer
+static inline bool hal_lcd_qspi_panel_pipelined(amoled_qspi_bus_obj_t *qspi_panel_obj, size_t param_size)
+{
+    return qspi_panel_obj->hw_cs && (qspi_panel_obj->queue_depth > 0) && (param_size <= 4);
+}
+
+
+// Send a command and its parameters, the bus must be idle unless the command is pipelined
+static void hal_lcd_qspi_panel_send_param(amoled_qspi_bus_obj_t *qspi_panel_obj,
+                                          int                    lcd_cmd,
+                                          const void            *param,
+                                          size_t                 param_size)
+{
+    DEBUG_printf("hal_lcd_qspi_panel_send_param cmd: %x, param_size: %u\n", lcd_cmd, param_size);
+
+    spi_transaction_ext_t t;
+
+    memset(&t, 0, sizeof(t));
+    t.base.flags = (SPI_TRANS_MULTILINE_CMD | SPI_TRANS_MULTILINE_ADDR);
+    t.base.cmd = 0x02;
+    t.base.addr = lcd_cmd << 8;
+    t.base.length = qspi_panel_obj->cmd_bits * param_size;
+
+    if (hal_lcd_qspi_panel_pipelined(qspi_panel_obj, param_size)) {
+        // parameters are copied in the transaction, the caller buffer may be gone before it is sent
+        t.base.flags |= SPI_TRANS_USE_TXDATA;
+        if (param_size != 0) {
+            memcpy(t.base.tx_data, param, param_size);
+        }
+        hal_lcd_qspi_panel_queue(qspi_panel_obj, &t, false);
+        return;
+    }
+    t.base.tx_buffer = (param_size != 0) ? param : NULL;
+    hal_lcd_qspi_panel_cs_low(qspi_panel_obj);
+    hal_lcd_qspi_panel_poll(qspi_panel_obj, (spi_transaction_t *)&t);
+    hal_lcd_qspi_panel_cs_high(qspi_panel_obj);
+}
+
+
 static void hal_lcd_qspi_panel_tx_param(mp_obj_base_t *self,
                                         int            lcd_cmd,
                                         const void    *param,
                                         size_t         param_size)
 {
-    DEBUG_printf("hal_lcd_qspi_panel_tx_param cmd: %x, param_size: %u\n", lcd_cmd, param_size);
-
     amoled_qspi_bus_obj_t *qspi_panel_obj = (amoled_qspi_bus_obj_t *)self;
-    machine_hw_spi_obj_t *spi_obj = ((machine_hw_spi_obj_t *)qspi_panel_obj->spi_obj);
-    spi_transaction_t t;
-    memset(&t, 0, sizeof(t));
-    t.flags = (SPI_TRANS_MULTILINE_CMD | SPI_TRANS_MULTILINE_ADDR);
-    t.cmd = 0x02;
-    t.addr = lcd_cmd << 8;
-    if (param_size != 0) {
-        t.tx_buffer = param;
-        t.length = qspi_panel_obj->cmd_bits * param_size;
-    } else {
-        t.tx_buffer = NULL;
-        t.length = 0;
+
+    if (!hal_lcd_qspi_panel_pipelined(qspi_panel_obj, param_size)) {
+        hal_lcd_qspi_panel_wait(self);          // polling is not allowed while transactions are queued
     }
-    mp_hal_pin_od_low(qspi_panel_obj->cs_pin);
-    spi_device_polling_transmit(spi_obj->spi, &t);
-    mp_hal_pin_od_high(qspi_panel_obj->cs_pin);
+    hal_lcd_qspi_panel_send_param(qspi_panel_obj, lcd_cmd, param, param_size);
 }
 
 
-static void hal_lcd_qspi_panel_tx_color(mp_obj_base_t *self,			// tx_color(self->bus_obj, 0, buf, len);	
-                                        int            lcd_cmd,			// 0 in below command
-                                        const void    *color,			// pointer to color buffer (full character for example)
-                                        size_t         color_size)		// size of color buffer
+// Send a memory write command (0 : RAMWR, or RAMWRC) and the colors, the bus must be idle
+static void hal_lcd_qspi_panel_send_color(amoled_qspi_bus_obj_t *qspi_panel_obj,	// qspi_panel_obj is pointer to display buffer
+                                          int                    lcd_cmd,			// 0 for RAMWR
+                                          const void            *color,			// pointer to color buffer (full character for example)
+                                          size_t                 color_size)		// size of color buffer
 {
-    DEBUG_printf("hal_lcd_qspi_panel_tx_color cmd:, color_size: %u\n", /* lcd_cmd, */ color_size);
+    DEBUG_printf("hal_lcd_qspi_panel_send_color cmd: %x, color_size: %u\n", lcd_cmd, color_size);
 
-    amoled_qspi_bus_obj_t *qspi_panel_obj = (amoled_qspi_bus_obj_t *)self;			// qspi_panel_obj is pointer to display buffer
-    machine_hw_spi_obj_t *spi_obj = ((machine_hw_spi_obj_t *)qspi_panel_obj->spi_obj);  // spi_obj is pointer to spi 
     spi_transaction_ext_t t;															// t is spi transactionner
+    bool async = (qspi_panel_obj->queue_depth > 0);
+    uint32_t keep_cs = qspi_panel_obj->hw_cs ? SPI_TRANS_CS_KEEP_ACTIVE : 0;		// hardware CS stays low from header to last chunk
 
-    mp_hal_pin_od_low(qspi_panel_obj->cs_pin);  // Activate SPI bus transfert by CS_Pin 
+    hal_lcd_qspi_panel_acquire(qspi_panel_obj);
+    hal_lcd_qspi_panel_cs_low(qspi_panel_obj);  // Activate SPI bus transfert by CS_Pin 
     memset(&t, 0, sizeof(t));                   // Clear SPI transactionner
 	
 	//Preprare writting transaction
-    t.base.flags = SPI_TRANS_MODE_QIO;
+    t.base.flags = SPI_TRANS_MODE_QIO | keep_cs;
     t.base.cmd = 0x32;
-    t.base.addr = 0x002C00;                    // 2C00 is the memory write adress (LCD_CMD_RAMWR)
-    spi_device_polling_transmit(spi_obj->spi, (spi_transaction_t *)&t);
+    t.base.addr = (lcd_cmd ? lcd_cmd : 0x2C) << 8;   // 2C00 is the memory write adress (LCD_CMD_RAMWR), 3C00 continues it (LCD_CMD_RAMWRC)
+    esp_err_t ret;
+    if (async) {
+        qspi_panel_obj->cs_active = !qspi_panel_obj->hw_cs;     // CS will be released by hal_lcd_qspi_panel_wait
+        qspi_panel_obj->last_trans = NULL;
+        ret = hal_lcd_qspi_panel_queue(qspi_panel_obj, &t, false);
+    } else {
+        ret = hal_lcd_qspi_panel_poll(qspi_panel_obj, (spi_transaction_t *)&t);
+    }
 
     uint8_t *p_color = (uint8_t *)color;      // Convert color buffer to uint8_t *
     size_t chunk_size;
@@ -130,10 +322,7 @@ static void hal_lcd_qspi_panel_tx_color(mp_obj_base_t *self,			// tx_color(self-
     t.address_bits = 0;
     t.dummy_bits = 0;
 	
-	//Added during checks over artefacts
-	//spi_device_acquire_bus(spi_obj->spi, portMAX_DELAY);
-    
-    do {
+    while (ret == ESP_OK) {                   // a failed transaction ends the transfer
         if (len > SEND_BUF_SIZE) {            // shorten to send buffer max length
             chunk_size = SEND_BUF_SIZE;
         } else {
@@ -141,16 +330,68 @@ static void hal_lcd_qspi_panel_tx_color(mp_obj_base_t *self,			// tx_color(self-
         }
         t.base.tx_buffer = p_color;
 		t.base.length = chunk_size * 8;      //  Nb of bit to tranmit (=> *8) 
-		//Transmit using polling method
-        spi_device_polling_transmit(spi_obj->spi, (spi_transaction_t *)&t);
         len -= chunk_size;                   // next chunk if necessary
         p_color += chunk_size;               
-    } while (len > 0);
-	
-	//Added...
-	//spi_device_release_bus(spi_obj->spi);
+        t.base.flags = (t.base.flags & ~SPI_TRANS_CS_KEEP_ACTIVE) | ((len > 0) ? keep_cs : 0);
+        if (async) {
+            //Queue the chunk, the last one is flagged to trigger the completion callback
+            ret = hal_lcd_qspi_panel_queue(qspi_panel_obj, &t, (len == 0));
+        } else {
+            //Transmit using polling method
+            ret = hal_lcd_qspi_panel_poll(qspi_panel_obj, (spi_transaction_t *)&t);
+        }
+        if (len == 0) {
+            break;
+        }
+    }
 
-    mp_hal_pin_od_high(qspi_panel_obj->cs_pin);				// Desactivate SPI bus transfert by CS_Pin 
+    if (!async) {
+        hal_lcd_qspi_panel_cs_high(qspi_panel_obj);				// Desactivate SPI bus transfert by CS_Pin 
+        hal_lcd_qspi_panel_release(qspi_panel_obj);
+    }
+}
+
+
+static void hal_lcd_qspi_panel_tx_color(mp_obj_base_t *self,			// tx_color(self->bus_obj, 0, buf, len);	
+                                        int            lcd_cmd,
+                                        const void    *color,
+                                        size_t         color_size)
+{
+    hal_lcd_qspi_panel_wait(self);              // previous transfer must be over before a new RAMWR
+    hal_lcd_qspi_panel_send_color((amoled_qspi_bus_obj_t *)self, lcd_cmd, color, color_size);
+}
+
+
+// Window and memory write back to back : a single wait for the previous transfer instead of three,
+// with hardware CS and a queue, CASET / RASET / RAMWR and the chunks are all queued in a row
+static void hal_lcd_qspi_panel_tx_window(mp_obj_base_t *self,
+                                         const uint8_t *caset,
+                                         const uint8_t *raset,
+                                         int            lcd_cmd,
+                                         const void    *color,
+                                         size_t         color_size)
+{
+    amoled_qspi_bus_obj_t *qspi_panel_obj = (amoled_qspi_bus_obj_t *)self;
+
+    hal_lcd_qspi_panel_wait(self);
+    hal_lcd_qspi_panel_acquire(qspi_panel_obj);
+    if (caset) {
+        hal_lcd_qspi_panel_send_param(qspi_panel_obj, 0x2A, caset, 4);   // LCD_CMD_CASET
+    }
+    if (raset) {
+        hal_lcd_qspi_panel_send_param(qspi_panel_obj, 0x2B, raset, 4);   // LCD_CMD_RASET
+    }
+    hal_lcd_qspi_panel_send_color(qspi_panel_obj, lcd_cmd, color, color_size);
+}
+
+
+static int hal_lcd_qspi_panel_error(mp_obj_base_t *self)
+{
+    amoled_qspi_bus_obj_t *qspi_panel_obj = (amoled_qspi_bus_obj_t *)self;
+    esp_err_t ret = qspi_panel_obj->error;
+
+    qspi_panel_obj->error = ESP_OK;
+    return ret;
 }
 
 
@@ -160,6 +401,7 @@ static void hal_lcd_qspi_panel_deinit(mp_obj_base_t *self)
     machine_hw_spi_obj_t *spi_obj = ((machine_hw_spi_obj_t *)qspi_panel_obj->spi_obj);
     
     if (spi_obj->state == MACHINE_HW_SPI_STATE_INIT) {
+        hal_lcd_qspi_panel_wait(self);
         spi_obj->state = MACHINE_HW_SPI_STATE_DEINIT;
         machine_hw_spi_deinit_internal(spi_obj);
     }
@@ -174,14 +416,16 @@ static void amoled_qspi_bus_print(const mp_print_t *print,
     amoled_qspi_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
     mp_printf(
         print,
-        "<QSPI Panel SPI=%p, dc=%p, cs=%p, width=%u, height=%u, cmd_bits=%u, param_bits=%u>",
+        "<QSPI Panel SPI=%p, dc=%p, cs=%p, width=%u, height=%u, cmd_bits=%u, param_bits=%u, queue_depth=%u, hw_cs=%u>",
         self->spi_obj,
         self->dc,
         self->cs,
         self->width,
         self->height,
         self->cmd_bits,
-        self->param_bits
+        self->param_bits,
+        self->queue_depth,
+        self->hw_cs
     );
 }
 
@@ -200,7 +444,10 @@ static mp_obj_t amoled_qspi_bus_make_new(const mp_obj_type_t *type,
         ARG_width,
         ARG_height,
         ARG_cmd_bits,
-        ARG_param_bits
+        ARG_param_bits,
+        ARG_queue_depth,
+        ARG_callback,
+        ARG_hw_cs
     };
     const mp_arg_t make_new_args[] = {
         { MP_QSTR_spi,              MP_ARG_OBJ | MP_ARG_KW_ONLY | MP_ARG_REQUIRED        },
@@ -212,6 +459,9 @@ static mp_obj_t amoled_qspi_bus_make_new(const mp_obj_type_t *type,
         { MP_QSTR_height,           MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 240        } },
         { MP_QSTR_cmd_bits,         MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 8         }  },
         { MP_QSTR_param_bits,       MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 8         }  },
+        { MP_QSTR_queue_depth,      MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 0         }  },
+        { MP_QSTR_callback,         MP_ARG_OBJ | MP_ARG_KW_ONLY,  {.u_obj = mp_const_none} },
+        { MP_QSTR_hw_cs,            MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false     } },
     };
     mp_arg_val_t args[MP_ARRAY_SIZE(make_new_args)];
     mp_arg_parse_all_kw_array(
@@ -242,6 +492,24 @@ static mp_obj_t amoled_qspi_bus_make_new(const mp_obj_type_t *type,
     self->cmd_bits   = args[ARG_cmd_bits].u_int;
     self->param_bits = args[ARG_param_bits].u_int;
 
+    // async mode : 0 = polling (default), 1..AMOLED_QUEUE_MAX_DEPTH = queued transactions
+    if ((args[ARG_queue_depth].u_int < 0) || (args[ARG_queue_depth].u_int > AMOLED_QUEUE_MAX_DEPTH)) {
+        mp_raise_ValueError(MP_ERROR_TEXT("queue_depth out of range"));
+    }
+    self->queue_depth = args[ARG_queue_depth].u_int;
+    self->queued      = 0;
+    self->cs_active   = false;
+    self->issued      = 0;
+    self->completed   = 0;
+    self->last_trans  = NULL;
+    self->error       = ESP_OK;
+    self->callback    = args[ARG_callback].u_obj;
+
+    // CS driven by the SPI peripheral instead of GPIO toggling
+    self->hw_cs        = args[ARG_hw_cs].u_bool;
+    self->bus_acquired = false;
+    memset((void *)self->latency, 0, sizeof(self->latency));
+
     hal_lcd_qspi_panel_construct(&self->base);
     return MP_OBJ_FROM_PTR(self);
 }
@@ -282,6 +550,58 @@ static mp_obj_t amoled_qspi_bus_tx_color(size_t n_args, const mp_obj_t *args_in)
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_qspi_bus_tx_color_obj, 2, 3, amoled_qspi_bus_tx_color);
 
 
+// Block until the last color transfer is sent
+static mp_obj_t amoled_qspi_bus_wait(mp_obj_t self_in)
+{
+    mp_obj_base_t *self = (mp_obj_base_t *)MP_OBJ_TO_PTR(self_in);
+
+    hal_lcd_qspi_panel_wait(self);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_qspi_bus_wait_obj, amoled_qspi_bus_wait);
+
+
+// True while queued transactions are still on the wire
+static mp_obj_t amoled_qspi_bus_busy(mp_obj_t self_in)
+{
+    amoled_qspi_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    return mp_obj_new_bool(self->completed != self->issued);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(amoled_qspi_bus_busy_obj, amoled_qspi_bus_busy);
+
+
+// Set (or clear with None) the function called when a color transfer is done
+static mp_obj_t amoled_qspi_bus_callback(mp_obj_t self_in, mp_obj_t callback_in)
+{
+    amoled_qspi_bus_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if ((callback_in != mp_const_none) && !mp_obj_is_callable(callback_in)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("callback must be callable or None"));
+    }
+    self->callback = callback_in;
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(amoled_qspi_bus_callback_obj, amoled_qspi_bus_callback);
+
+
+// Histogram of transaction latencies (from submission to completion) : bucket i counts [2^i, 2^(i+1)) us
+static mp_obj_t amoled_qspi_bus_latency(size_t n_args, const mp_obj_t *args_in)
+{
+    amoled_qspi_bus_obj_t *self = MP_OBJ_TO_PTR(args_in[0]);
+    mp_obj_t hist[AMOLED_LATENCY_BUCKETS];
+
+    for (size_t i = 0; i < AMOLED_LATENCY_BUCKETS; i++) {
+        hist[i] = mp_obj_new_int_from_uint(self->latency[i]);
+    }
+    if ((n_args > 1) && mp_obj_is_true(args_in[1])) {
+        memset((void *)self->latency, 0, sizeof(self->latency));
+    }
+    return mp_obj_new_tuple(AMOLED_LATENCY_BUCKETS, hist);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(amoled_qspi_bus_latency_obj, 1, 2, amoled_qspi_bus_latency);
+
+
 static mp_obj_t amoled_qspi_bus_deinit(mp_obj_t self_in)
 {
     mp_obj_base_t *self = (mp_obj_base_t *)MP_OBJ_TO_PTR(self_in);
@@ -296,6 +616,10 @@ static MP_DEFINE_CONST_FUN_OBJ_1(amoled_qspi_bus_deinit_obj, amoled_qspi_bus_dei
 static const mp_rom_map_elem_t amoled_qspi_bus_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_tx_param), MP_ROM_PTR(&amoled_qspi_bus_tx_param_obj) },
     { MP_ROM_QSTR(MP_QSTR_tx_color), MP_ROM_PTR(&amoled_qspi_bus_tx_color_obj) },
+    { MP_ROM_QSTR(MP_QSTR_wait),     MP_ROM_PTR(&amoled_qspi_bus_wait_obj)     },
+    { MP_ROM_QSTR(MP_QSTR_busy),     MP_ROM_PTR(&amoled_qspi_bus_busy_obj)     },
+    { MP_ROM_QSTR(MP_QSTR_callback), MP_ROM_PTR(&amoled_qspi_bus_callback_obj) },
+    { MP_ROM_QSTR(MP_QSTR_latency),  MP_ROM_PTR(&amoled_qspi_bus_latency_obj)  },
     { MP_ROM_QSTR(MP_QSTR_deinit),   MP_ROM_PTR(&amoled_qspi_bus_deinit_obj)   },
     { MP_ROM_QSTR(MP_QSTR___del__),  MP_ROM_PTR(&amoled_qspi_bus_deinit_obj)   },
 };
@@ -305,7 +629,10 @@ static MP_DEFINE_CONST_DICT(amoled_qspi_bus_locals_dict, amoled_qspi_bus_locals_
 static const amoled_panel_p_t mp_lcd_panel_p = {
     .tx_param = hal_lcd_qspi_panel_tx_param,
     .tx_color = hal_lcd_qspi_panel_tx_color,
-    .deinit = hal_lcd_qspi_panel_deinit
+    .deinit = hal_lcd_qspi_panel_deinit,
+    .wait = hal_lcd_qspi_panel_wait,
+    .tx_window = hal_lcd_qspi_panel_tx_window,
+    .error = hal_lcd_qspi_panel_error
 };
 
 
@@ -5,12 +5,9 @@
 #include "py/obj.h"
 #include "esp_lcd_panel_io.h"
 #include "driver/spi_master.h"
+#include "amoled_panel.h"
 
-typedef struct _amoled_panel_p_t {
-    void (*tx_param)(mp_obj_base_t *self, int lcd_cmd, const void *param, size_t param_size);
-    void (*tx_color)(mp_obj_base_t *self, int lcd_cmd, const void *color, size_t color_size);
-    void (*deinit)(mp_obj_base_t *self);
-} amoled_panel_p_t;
+#define AMOLED_LATENCY_BUCKETS  16      // Latency histogram, bucket i counts [2^i, 2^(i+1)) us
 
 typedef struct _amoled_qspi_bus_obj_t {
     mp_obj_base_t base;
@@ -30,6 +27,24 @@ typedef struct _amoled_qspi_bus_obj_t {
     int cmd_bits;
     int param_bits;
 
+    // Asynchronous color transfer, queue_depth = 0 keeps the blocking polling mode
+    uint8_t queue_depth;                // Max in-flight transactions
+    uint8_t queued;                     // Transactions queued and not yet reclaimed
+    bool cs_active;                     // CS is held low until the queue is drained
+    volatile uint32_t issued;           // Transactions sent to the SPI driver
+    volatile uint32_t completed;        // Transactions finished (counted in post_cb)
+    spi_transaction_t *last_trans;      // Last transaction of the current color transfer
+    mp_obj_t callback;                  // Called (scheduled) when a color transfer is done
+    spi_transaction_ext_t trans[AMOLED_QUEUE_MAX_DEPTH];
+    uint32_t trans_start[AMOLED_QUEUE_MAX_DEPTH];  // esp_timer time each ring slot was queued
+
+    // Hardware CS : the SPI peripheral drives CS, the bus is acquired for multi-transaction sequences
+    bool hw_cs;
+    bool bus_acquired;
+    volatile uint32_t latency[AMOLED_LATENCY_BUCKETS];
+
+    esp_err_t error;                    // First failed SPI driver call since the last error() (ESP_OK if none)
+
     // spi_device_handle_t io_handle;
     enum {
         MACHINE_HW_QSPI_STATE_NONE,
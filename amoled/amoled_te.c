@@ -0,0 +1,197 @@
+#include "amoled_te.h"
+
+#include <stddef.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "driver/gpio.h"
+#else
+#include <time.h>
+#include <errno.h>
+#endif
+
+
+/*
+Tearing effect synchronisation. The sources only have to tell when the next TE edge comes, so
+the pacer runs the same with the panel TE pin or with a timer driven fake TE on a host.
+amoled_te_frame() never touches MicroPython objects : it is also called by the present task.
+*/
+
+
+#ifdef ESP_PLATFORM
+
+int64_t amoled_te_now(void)
+{
+    return esp_timer_get_time();
+}
+
+// Sleep with the scheduler for the bulk of the delay, then spin for the last tick
+static void te_sleep_until(int64_t t)
+{
+    int64_t left = t - amoled_te_now();
+    if (left > 2000) {
+        vTaskDelay(pdMS_TO_TICKS((left - 1000) / 1000));
+    }
+    while ((left = t - amoled_te_now()) > 0) {
+        esp_rom_delay_us(left > 100 ? 100 : left);
+    }
+}
+
+static void IRAM_ATTR te_isr(void *arg)
+{
+    amoled_te_t *te = (amoled_te_t *)arg;
+    int64_t now = esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+
+    if (te->edges) {
+        te->period_us = now - te->last_edge_us;
+    }
+    te->last_edge_us = now;
+    te->edges++;
+    xSemaphoreGiveFromISR(te->edge, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+bool amoled_te_pin(amoled_te_t *te, int pin)
+{
+    amoled_te_stop(te);
+    te->edge = xSemaphoreCreateBinary();
+    if (te->edge == NULL) {
+        return false;
+    }
+    te->pin = pin;
+    te->edges = 0;
+    te->period_us = 0;
+    gpio_set_direction(pin, GPIO_MODE_INPUT);
+    gpio_set_intr_type(pin, GPIO_INTR_POSEDGE);
+    esp_err_t ret = gpio_install_isr_service(0);        // already installed by machine.Pin is fine
+    if (((ret != ESP_OK) && (ret != ESP_ERR_INVALID_STATE)) || (gpio_isr_handler_add(pin, te_isr, te) != ESP_OK)) {
+        vSemaphoreDelete(te->edge);
+        te->edge = NULL;
+        return false;
+    }
+    te->source = TE_SOURCE_PIN;
+    return true;
+}
+
+// Wait for the next edge of the TE pin, false on timeout
+static bool te_pin_wait(amoled_te_t *te)
+{
+    xSemaphoreTake(te->edge, 0);        // an edge before the call is too old
+    return xSemaphoreTake(te->edge, pdMS_TO_TICKS(TE_TIMEOUT_US / 1000)) == pdTRUE;
+}
+
+static void te_pin_stop(amoled_te_t *te)
+{
+    gpio_isr_handler_remove(te->pin);
+    vSemaphoreDelete(te->edge);
+    te->edge = NULL;
+}
+
+#else
+
+int64_t amoled_te_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void te_sleep_until(int64_t t)
+{
+    int64_t left = t - amoled_te_now();
+    if (left > 0) {
+        struct timespec ts = { left / 1000000, (left % 1000000) * 1000 };
+        while ((nanosleep(&ts, &ts) != 0) && (errno == EINTR)) {
+        }
+    }
+}
+
+// No GPIO interrupt on a host, use amoled_te_timer()
+bool amoled_te_pin(amoled_te_t *te, int pin)
+{
+    (void)te;
+    (void)pin;
+    return false;
+}
+
+static bool te_pin_wait(amoled_te_t *te)
+{
+    (void)te;
+    return false;
+}
+
+static void te_pin_stop(amoled_te_t *te)
+{
+    (void)te;
+}
+
+#endif
+
+
+void amoled_te_timer(amoled_te_t *te, uint32_t period_us)
+{
+    amoled_te_stop(te);
+    if (period_us) {
+        te->period_us = period_us;
+        te->start_us = amoled_te_now();
+        te->source = TE_SOURCE_TIMER;
+    }
+}
+
+
+void amoled_te_stop(amoled_te_t *te)
+{
+    if (te->source == TE_SOURCE_PIN) {
+        te_pin_stop(te);
+    }
+    te->source = TE_SOURCE_NONE;
+    te->period_us = 0;
+}
+
+
+// Wait for the start of the next frame : frame slot of the pacer, then TE edge
+void amoled_te_frame(amoled_te_t *te)
+{
+    int64_t now = amoled_te_now();
+
+    if (te->frame_us) {
+        if (te->next_us == 0) {
+            te->next_us = now;
+        }
+        if (now > te->next_us + te->frame_us) {            // whole slots went by
+            te->missed += (now - te->next_us) / te->frame_us;
+            te->late++;
+            te->next_us = now;
+        } else if (now > te->next_us) {
+            te->late++;
+            te->next_us = now;
+        } else {
+            te_sleep_until(te->next_us);
+        }
+    }
+
+    switch (te->source) {
+        case TE_SOURCE_PIN:
+            if (!te_pin_wait(te)) {
+                te->timeouts++;
+            }
+        break;
+
+        case TE_SOURCE_TIMER: {
+            int64_t elapsed = amoled_te_now() - te->start_us;
+            int64_t edge = te->start_us + (elapsed / te->period_us + 1) * te->period_us;
+            te_sleep_until(edge);
+        }
+        break;
+    }
+
+    if (te->frame_us) {
+        // The next slot ends half a TE period early, so waiting for its edge does not skip one
+        te->next_us = amoled_te_now() + te->frame_us - te->period_us / 2;
+    }
+    te->frames++;
+}
@@ -0,0 +1,46 @@
+#ifndef __amoled_te_H__
+#define __amoled_te_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#endif
+
+#define TE_SOURCE_NONE         (0)
+#define TE_SOURCE_PIN          (1)      // TE output of the panel on a GPIO, rising edge interrupt
+#define TE_SOURCE_TIMER        (2)      // Fake TE computed from a fixed period (tests, panels without TE pin)
+
+#define TE_TIMEOUT_US          (100000) // Give up waiting for a TE edge after this time
+
+// Tearing effect source and frame pacer : a present first waits for its frame slot (target fps),
+// then for the next TE edge, so the transfer starts right after the scan passed the tear scanline
+typedef struct _amoled_te_t {
+    uint8_t  source;                    // TE_SOURCE_NONE / TE_SOURCE_PIN / TE_SOURCE_TIMER
+    int      pin;                       // TE GPIO (TE_SOURCE_PIN)
+    uint32_t period_us;                 // TE period : fixed (timer) or measured between edges (pin)
+    int64_t  start_us;                  // First edge of the fake TE
+    volatile uint32_t edges;            // Edges seen (pin)
+    volatile int64_t  last_edge_us;     // Time of the last edge (pin)
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t edge;             // Given by the TE interrupt
+#endif
+
+    // Frame pacer
+    uint32_t frame_us;                  // Target frame period (0 : no pacing, only TE)
+    int64_t  next_us;                   // Start of the next frame slot (0 : first frame)
+    uint32_t frames;                    // Paced frames
+    uint32_t late;                      // Frames started after their slot
+    uint32_t missed;                    // Whole frame slots skipped
+    uint32_t timeouts;                  // TE edges not seen within TE_TIMEOUT_US
+} amoled_te_t;
+
+int64_t amoled_te_now(void);
+bool amoled_te_pin(amoled_te_t *te, int pin);
+void amoled_te_timer(amoled_te_t *te, uint32_t period_us);
+void amoled_te_stop(amoled_te_t *te);
+void amoled_te_frame(amoled_te_t *te);
+
+#endif
@@ -5,6 +5,10 @@ add_library(usermod_amoled INTERFACE)
 target_sources(usermod_amoled INTERFACE
     ${CMAKE_CURRENT_LIST_DIR}/amoled.c
     ${CMAKE_CURRENT_LIST_DIR}/amoled_qspi_bus.c
+    ${CMAKE_CURRENT_LIST_DIR}/amoled_mock_bus.c
+    ${CMAKE_CURRENT_LIST_DIR}/amoled_mem_bus.c
+    ${CMAKE_CURRENT_LIST_DIR}/amoled_present.c
+    ${CMAKE_CURRENT_LIST_DIR}/amoled_te.c
     ${CMAKE_CURRENT_LIST_DIR}/mpfile/mpfile.c
     ${CMAKE_CURRENT_LIST_DIR}/jpg/tjpgd565.c
     ${CMAKE_CURRENT_LIST_DIR}/schrift/schrift.c
@@ -3,7 +3,11 @@ AMOLED_MOD_DIR := $(USERMOD_DIR)
 CFLAGS_USERMOD += -I$(AMOLED_MOD_DIR) -I$(AMOLED_MOD_DIR)/schrift
 
 SRC_USERMOD += $(AMOLED_MOD_DIR)/amoled.c
-SRC_USERMOD += $(AMOLED_MOD_DIR)/amoled_qspi_bus.c
+# amoled_qspi_bus.c needs ESP-IDF, the esp32 port builds it through micropython.cmake
+SRC_USERMOD += $(AMOLED_MOD_DIR)/amoled_mock_bus.c
+SRC_USERMOD += $(AMOLED_MOD_DIR)/amoled_mem_bus.c
+SRC_USERMOD += $(AMOLED_MOD_DIR)/amoled_present.c
+SRC_USERMOD += $(AMOLED_MOD_DIR)/amoled_te.c
 SRC_USERMOD += $(AMOLED_MOD_DIR)/jpg/tjpgd565.c
 SRC_USERMOD += $(AMOLED_MOD_DIR)/mpfile/mpfile.c
 SRC_USERMOD += $(AMOLED_MOD_DIR)/schrift/schrift.c
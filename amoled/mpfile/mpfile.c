@@ -69,6 +69,16 @@ mp_int_t mp_readinto(mp_file_t *file, void *buf, size_t num_bytes) {
     return nread;
 }
 
+mp_int_t mp_write(mp_file_t *file, const void *buf, size_t num_bytes) {
+    mp_obj_t write_fn = mp_load_attr(file->file_obj, MP_QSTR_write);
+    mp_obj_t bytearray = mp_obj_new_bytearray_by_ref(num_bytes, (void *)buf);
+    mp_obj_t bytes_written = mp_call_function_1(write_fn, bytearray);
+    if (bytes_written == mp_const_none) {
+        return 0;
+    }
+    return mp_obj_get_int(bytes_written);
+}
+
 off_t mp_seek(mp_file_t *file, off_t offset, int whence) {
     return mp_obj_get_int(mp_call_function_2(file->seek_fn,
                                              MP_OBJ_NEW_SMALL_INT(offset),
@@ -0,0 +1,257 @@
+/*
+Host test of the pixel kernels of amoled_port.h : each kernel is compared with a plain per pixel
+reference over random data, lengths and alignments. Pixels around the destination must stay intact.
+
+    cc -std=gnu11 -O2 -Wall -I../amoled test_kernels.c -o test_kernels && ./test_kernels
+
+Any target specific version of a kernel has to pass the same comparisons.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "amoled_port.h"
+
+#define PIXELS      256
+#define GUARD       8           // pixels checked on each side of the destination
+#define ROUNDS      2000
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        if (failures++ < 10) { \
+            printf("FAIL %s:%d ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } \
+} while (0)
+
+static uint32_t seed = 12345;
+
+static uint32_t rnd(void) {
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+
+static void rnd_fill(void *buf, size_t size) {
+    uint8_t *p = buf;
+    while (size--) {
+        *p++ = rnd();
+    }
+}
+
+// Mostly random bytes, with runs of 0x00 and 0xFF so the whole byte paths are taken
+static void rnd_bitmap(uint8_t *buf, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        switch (rnd() & 3) {
+            case 0: buf[i] = 0x00; break;
+            case 1: buf[i] = 0xFF; break;
+            default: buf[i] = rnd(); break;
+        }
+    }
+}
+
+static void check_pixels(const char *name, const uint16_t *got, const uint16_t *ref, size_t n, size_t off, size_t len) {
+    for (size_t i = 0; i < n; i++) {
+        if (got[i] != ref[i]) {
+            CHECK(0, "%s off %u len %u pixel %d : %04X instead of %04X", name, (unsigned)off, (unsigned)len,
+                (int)i - GUARD - (int)off, got[i], ref[i]);
+            return;
+        }
+    }
+}
+
+static void test_fill16(void) {
+    uint16_t got[PIXELS + 2 * GUARD], ref[PIXELS + 2 * GUARD];
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t off = rnd() & 7;
+        size_t len = rnd() % (PIXELS - 8);
+        uint16_t color = rnd();
+        rnd_fill(got, sizeof(got));
+        memcpy(ref, got, sizeof(got));
+        amoled_fill16(got + GUARD + off, color, len);
+        for (size_t i = 0; i < len; i++) {
+            ref[GUARD + off + i] = color;
+        }
+        check_pixels("fill16", got, ref, PIXELS + 2 * GUARD, off, len);
+    }
+}
+
+static void test_copy_swap16(void) {
+    uint16_t src[PIXELS], got[PIXELS + 2 * GUARD], ref[PIXELS + 2 * GUARD];
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t off = rnd() & 7;
+        size_t soff = rnd() & 7;
+        size_t len = rnd() % (PIXELS - 8);
+        rnd_fill(src, sizeof(src));
+        rnd_fill(got, sizeof(got));
+        memcpy(ref, got, sizeof(got));
+        amoled_copy_swap16(got + GUARD + off, src + soff, len);
+        for (size_t i = 0; i < len; i++) {
+            uint16_t c = src[soff + i];
+            ref[GUARD + off + i] = (c >> 8) | (c << 8);
+        }
+        check_pixels("copy_swap16", got, ref, PIXELS + 2 * GUARD, off, len);
+    }
+}
+
+static void test_expand8(void) {
+    uint8_t src[PIXELS];
+    uint16_t lut[256], got[PIXELS + 2 * GUARD], ref[PIXELS + 2 * GUARD];
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t off = rnd() & 7;
+        size_t len = rnd() % (PIXELS - 8);
+        rnd_fill(src, sizeof(src));
+        rnd_fill(lut, sizeof(lut));
+        rnd_fill(got, sizeof(got));
+        memcpy(ref, got, sizeof(got));
+        amoled_expand8(got + GUARD + off, src, lut, len);
+        for (size_t i = 0; i < len; i++) {
+            ref[GUARD + off + i] = lut[src[i]];
+        }
+        check_pixels("expand8", got, ref, PIXELS + 2 * GUARD, off, len);
+    }
+}
+
+static void test_expand_bits(void) {
+    uint8_t src[PIXELS];
+    uint16_t lut[256], got[PIXELS + 2 * GUARD], ref[PIXELS + 2 * GUARD];
+    for (int r = 0; r < ROUNDS; r++) {
+        uint8_t bpp = 1 << (rnd() % 3);                     // 1, 2 or 4
+        size_t bit = (rnd() % 64) & ~(size_t)(bpp - 1);     // pixels never straddle bytes
+        size_t len = rnd() % PIXELS;                        // src holds 8 bits per pixel, enough for any bpp
+        rnd_fill(src, sizeof(src));
+        rnd_fill(lut, sizeof(lut));
+        rnd_fill(got, sizeof(got));
+        memcpy(ref, got, sizeof(got));
+        amoled_expand_bits(got + GUARD, src, bit, bpp, lut, len);
+        for (size_t i = 0; i < len; i++) {
+            size_t b = bit + i * bpp;
+            ref[GUARD + i] = lut[(src[b >> 3] >> (8 - bpp - (b & 7))) & ((1 << bpp) - 1)];
+        }
+        check_pixels("expand_bits", got, ref, PIXELS + 2 * GUARD, bit, len);
+    }
+}
+
+static void test_expand1(void) {
+    uint8_t src[PIXELS / 8 + 2];
+    uint16_t got[PIXELS + 2 * GUARD], ref[PIXELS + 2 * GUARD];
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t bit = rnd() % 16;
+        size_t len = rnd() % (PIXELS - 16);
+        uint16_t fg = rnd();
+        uint16_t bg = rnd();
+        bool bg_filled = rnd() & 1;
+        rnd_bitmap(src, sizeof(src));
+        rnd_fill(got, sizeof(got));
+        memcpy(ref, got, sizeof(got));
+        amoled_expand1(got + GUARD, src, bit, fg, bg, bg_filled, len);
+        for (size_t i = 0; i < len; i++) {
+            size_t b = bit + i;
+            if (src[b >> 3] & (0x80 >> (b & 7))) {
+                ref[GUARD + i] = fg;
+            } else if (bg_filled) {
+                ref[GUARD + i] = bg;
+            }
+        }
+        check_pixels("expand1", got, ref, PIXELS + 2 * GUARD, bit, len);
+    }
+}
+
+// Per channel blend with 5 bits of alpha, rounded down as the packed version does
+static uint16_t blend_ref(uint16_t bg, uint16_t fg, uint8_t a) {
+    if (a == 0) {
+        return bg;
+    }
+    if (a == 255) {
+        return fg;
+    }
+    int a5 = (a + 4) >> 3;
+    int r = (bg >> 11) + ((((fg >> 11) - (bg >> 11)) * a5) >> 5);
+    int g = ((bg >> 5) & 0x3F) + (((((fg >> 5) & 0x3F) - ((bg >> 5) & 0x3F)) * a5) >> 5);
+    int b = (bg & 0x1F) + ((((fg & 0x1F) - (bg & 0x1F)) * a5) >> 5);
+    return (r << 11) | (g << 5) | b;
+}
+
+static void test_blend_alpha8(void) {
+    uint8_t alpha[PIXELS];
+    uint16_t got[PIXELS + 2 * GUARD], ref[PIXELS + 2 * GUARD];
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t len = rnd() % PIXELS;
+        uint16_t fg = rnd();
+        bool swap = rnd() & 1;
+        for (size_t i = 0; i < len; i++) {  // edges of glyphs : mostly 0 and 255
+            switch (rnd() & 3) {
+                case 0: alpha[i] = 0; break;
+                case 1: alpha[i] = 255; break;
+                default: alpha[i] = rnd(); break;
+            }
+        }
+        rnd_fill(got, sizeof(got));
+        memcpy(ref, got, sizeof(got));
+        amoled_blend_alpha8(got + GUARD, alpha, swap ? AMOLED_SWAP16(fg) : fg, swap, len);
+        for (size_t i = 0; i < len; i++) {
+            uint16_t bg = ref[GUARD + i];
+            if (swap) {
+                ref[GUARD + i] = AMOLED_SWAP16(blend_ref(AMOLED_SWAP16(bg), fg, alpha[i]));
+            } else {
+                ref[GUARD + i] = blend_ref(bg, fg, alpha[i]);
+            }
+        }
+        check_pixels(swap ? "blend_alpha8 swapped" : "blend_alpha8", got, ref, PIXELS + 2 * GUARD, 0, len);
+    }
+
+    // Every alpha over every channel extreme
+    for (int a = 0; a < 256; a++) {
+        uint16_t px[4] = { 0x0000, 0xFFFF, 0xF800, 0x07E0 };
+        uint16_t fg[4] = { 0xFFFF, 0x0000, 0x07FF, 0xF81F };
+        for (int i = 0; i < 4; i++) {
+            uint16_t c = px[i];
+            uint8_t al = a;
+            amoled_blend_alpha8(&c, &al, fg[i], false, 1);
+            CHECK(c == blend_ref(px[i], fg[i], a), "blend_alpha8 %04X over %04X alpha %d : %04X instead of %04X",
+                fg[i], px[i], a, c, blend_ref(px[i], fg[i], a));
+        }
+    }
+}
+
+static void test_fill_bits(void) {
+    uint8_t got[PIXELS / 8 + 2 * GUARD], ref[PIXELS / 8 + 2 * GUARD];
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t bit = GUARD * 8 + rnd() % 16;
+        size_t nbits = rnd() % (PIXELS - 16);
+        uint8_t pattern = rnd();
+        rnd_fill(got, sizeof(got));
+        memcpy(ref, got, sizeof(got));
+        amoled_fill_bits(got, bit, nbits, pattern);
+        for (size_t i = bit; i < bit + nbits; i++) {
+            uint8_t mask = 0x80 >> (i & 7);
+            ref[i >> 3] = (ref[i >> 3] & ~mask) | (pattern & mask);
+        }
+        for (size_t i = 0; i < sizeof(got); i++) {
+            if (got[i] != ref[i]) {
+                CHECK(0, "fill_bits bit %u nbits %u byte %u : %02X instead of %02X", (unsigned)bit, (unsigned)nbits,
+                    (unsigned)i, got[i], ref[i]);
+                break;
+            }
+        }
+    }
+}
+
+int main(void) {
+    test_fill16();
+    test_copy_swap16();
+    test_expand8();
+    test_expand_bits();
+    test_expand1();
+    test_blend_alpha8();
+    test_fill_bits();
+
+    if (failures) {
+        printf("%d failures\n", failures);
+        return 1;
+    }
+    printf("kernels OK\n");
+    return 0;
+}
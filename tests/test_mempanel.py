@@ -0,0 +1,117 @@
+"""
+MemPanel GRAM checks, on the unix port :
+
+    micropython tests/test_mempanel.py
+
+The frame is drawn in every rotation and the whole GRAM is compared with the image a reference
+model of the panel addressing (MADCTL MX, MY, MV) gives.
+"""
+
+import amoled
+
+W, H = 240, 536                 # type 0 (RM67162), no offsets
+
+panel = amoled.MemPanel(width=W, height=H)
+display = amoled.AMOLED(panel, type=0, bpp=16)
+
+
+def bus(color):
+    # API colors are stored in bus order, the first byte sent is the low byte of the value
+    return ((color & 0xFF) << 8) | (color >> 8)
+
+
+def gram_xy(rotation, x, y):
+    # Logical pixel to GRAM pixel, as the panel maps its write pointer
+    if rotation == 0:
+        return x, y
+    if rotation == 1:           # MX | MV
+        return y, H - 1 - x
+    if rotation == 2:           # MX | MY
+        return W - 1 - x, H - 1 - y
+    return W - 1 - y, x         # MV | MY
+
+
+RECTS = [
+    (0, 0, 10, 6, amoled.RED),
+    (17, 33, 40, 21, amoled.GREEN),
+    (100, 3, 1, 90, amoled.BLUE),
+    (5, 200, 120, 1, amoled.YELLOW),
+    (230, 230, 10, 10, display.colorRGB(12, 34, 56)),
+]
+
+
+def expected(rotation, bg):
+    c = bus(bg)
+    img = bytearray(bytes((c >> 8, c & 0xFF, 0)) * (W * H))
+    for x0, y0, w, h, color in RECTS:
+        c = bus(color)
+        for y in range(y0, y0 + h):
+            for x in range(x0, x0 + w):
+                gx, gy = gram_xy(rotation, x, y)
+                i = (gy * W + gx) * 3
+                img[i] = c >> 8
+                img[i + 1] = c & 0xFF
+    return img
+
+
+# Registers after the constructor
+sc, ec, sr, er, madctl, colmod = panel.registers()
+assert colmod == 0x55, "colmod %02x" % colmod
+assert madctl == 0, "madctl %02x" % madctl
+
+for rotation in range(4):
+    display.rotation(rotation)
+    w, h = display.width(), display.height()
+    assert (w, h) == ((W, H) if rotation & 1 == 0 else (H, W)), "rotation %d size %d x %d" % (rotation, w, h)
+
+    panel.clear()
+    display.fill(amoled.MAGENTA)
+    for x0, y0, rw, rh, color in RECTS:
+        display.fill_rect(x0, y0, rw, rh, color)
+
+    ref = expected(rotation, amoled.MAGENTA)
+    gram = panel.gram()
+    if gram != ref:
+        for i in range(0, len(ref), 3):
+            if gram[i:i + 2] != ref[i:i + 2]:
+                p = i // 3
+                raise AssertionError("rotation %d GRAM (%d, %d) : %02x%02x instead of %02x%02x"
+                    % (rotation, p % W, p // W, gram[i], gram[i + 1], ref[i], ref[i + 1]))
+
+    # Corners of the logical frame through panel.pixel()
+    for x, y in ((0, 0), (w - 1, 0), (0, h - 1), (w - 1, h - 1)):
+        gx, gy = gram_xy(rotation, x, y)
+        want = bus(amoled.RED) if (x, y) == (0, 0) else bus(amoled.MAGENTA)
+        assert panel.pixel(gx, gy) == want, "rotation %d corner (%d, %d)" % (rotation, x, y)
+
+# Pixels are never written outside of the GRAM
+params, colors, param_bytes, color_bytes, pixels, clipped = panel.stats()
+assert clipped == 0, "%d pixels clipped" % clipped
+assert pixels > 0
+
+# Auto refresh off : nothing reaches the GRAM until refresh()
+display.rotation(0)
+display.fill(amoled.BLACK)
+display.auto_refresh(amoled.AMOLED.REFRESH_OFF)
+panel.reset_stats()
+display.fill_rect(50, 60, 8, 8, amoled.WHITE)
+assert panel.stats()[3] == 0, "color bytes sent with auto refresh off"
+assert panel.pixel(50, 60) == 0
+display.refresh(50, 60, 8, 8)
+assert panel.pixel(50, 60) == 0xFFFF
+assert panel.pixel(57, 67) == 0xFFFF
+assert panel.pixel(58, 68) == 0
+
+# Deferred mode : flush() sends the recorded areas only
+display.auto_refresh(amoled.AMOLED.REFRESH_DEFERRED)
+panel.reset_stats()
+display.pixel(3, 4, amoled.CYAN)
+display.pixel(200, 500, amoled.CYAN)
+assert panel.pixel(3, 4) == 0
+display.flush()
+assert panel.pixel(3, 4) == bus(amoled.CYAN)
+assert panel.pixel(200, 500) == bus(amoled.CYAN)
+assert panel.stats()[3] < W * H * 2, "flush() sent the whole frame"
+
+display.deinit()
+print("mempanel OK")
@@ -0,0 +1,76 @@
+"""
+MockPanel protocol checks, on the unix port :
+
+    micropython tests/test_mockpanel.py
+
+Transactions stay in flight until complete() or wait(), color data is summed in the checksum
+when a transaction completes.
+"""
+
+import amoled
+
+W, H = 240, 536                 # type 0 (RM67162)
+
+
+def pixel_sum(color):
+    return (color & 0xFF) + (color >> 8)
+
+
+# Arguments
+try:
+    amoled.MockPanel(queue_depth=9)
+    raise AssertionError("queue_depth 9 accepted")
+except ValueError:
+    pass
+
+panel = amoled.MockPanel(width=W, height=H, queue_depth=3)
+try:
+    panel.callback(1)
+    raise AssertionError("callback 1 accepted")
+except TypeError:
+    pass
+
+display = amoled.AMOLED(panel, type=0, bpp=16)
+panel.wait()
+assert not panel.busy()
+assert panel.stats()[4] == 0
+
+# A whole frame : every byte is sent once and read back at completion
+panel.reset_stats()
+display.fill(0x1234)
+params, colors, color_bytes, transactions, queued, max_queued, stalls, checksum = panel.stats()
+assert color_bytes == W * H * 2, "color_bytes %d" % color_bytes
+assert colors >= 1
+assert 0 < max_queued <= 3, "max_queued %d" % max_queued
+assert panel.busy() == (queued > 0)
+
+# complete() finishes transactions one by one and returns what is left in flight
+left = queued
+while left:
+    assert panel.complete() == left - 1
+    left -= 1
+assert not panel.busy()
+assert panel.complete(5) == 0
+assert panel.stats()[7] == W * H * pixel_sum(0x1234), "checksum %d" % panel.stats()[7]
+
+# reset_stats() clears every counter
+panel.reset_stats()
+assert panel.stats() == (0, 0, 0, 0, 0, 0, 0, 0), panel.stats()
+
+# Callback : scheduled once per color transfer when its last transaction completes
+done = []
+panel.callback(lambda p: done.append(p))
+display.fill_rect(10, 10, 20, 20, 0xFFFF)
+panel.wait()
+for i in range(10):             # let the scheduler run the callbacks
+    pass
+assert done and done[0] is panel, "callback not called"
+panel.callback(None)
+
+# Commands wait for the queue to drain, like on the QSPI bus
+display.fill(0x0000)
+display.brightness(50)
+assert not panel.busy()
+
+display.deinit()
+print("mockpanel OK")
@@ -0,0 +1,81 @@
+"""
+Frame pacer with the timer driven fake TE, on the unix port :
+
+    micropython tests/test_pacing.py
+
+Bounds on the elapsed time are lower bounds only, a loaded host can only make frames later.
+"""
+
+import time
+import amoled
+
+panel = amoled.MockPanel(width=240, height=536)
+display = amoled.AMOLED(panel, type=0, bpp=16, auto_refresh=amoled.AMOLED.REFRESH_OFF)
+
+for bad in (lambda: display.fake_te(-1), lambda: display.pacing(-1)):
+    try:
+        bad()
+        raise AssertionError("negative rate accepted")
+    except ValueError:
+        pass
+
+
+def run(frames):
+    t0 = time.ticks_us()
+    for i in range(frames):
+        display.refresh()
+    return time.ticks_diff(time.ticks_us(), t0)
+
+
+# Fake TE at 100 Hz : every refresh() starts on the next edge, 10 ms apart
+display.fake_te(100)
+display.pacing_stats(True)
+assert display.pacing() == 0
+elapsed = run(10)
+frames, late, missed, timeouts, period = display.pacing_stats()
+assert period == 10000, "TE period %d" % period
+assert frames == 10, "%d frames" % frames
+assert (late, missed, timeouts) == (0, 0, 0)
+assert elapsed >= 9 * 10000, "10 frames in %d us" % elapsed
+
+# Pacer at 25 fps : a frame slot is 40 ms, the next slot ends half a TE period early
+assert display.pacing(25) == 25
+display.pacing_stats(True)
+elapsed = run(5)
+frames, late, missed, timeouts, period = display.pacing_stats()
+assert frames == 5
+assert elapsed >= 4 * (40000 - 5000), "5 frames in %d us" % elapsed
+
+# A frame far after its slot is late and counts the slots it missed
+time.sleep_ms(200)
+display.refresh()
+frames, late, missed, timeouts, period = display.pacing_stats(True)
+assert frames == 6
+assert late >= 1, "late %d" % late
+assert missed >= 3, "missed %d" % missed
+assert timeouts == 0
+assert display.pacing_stats()[:4] == (0, 0, 0, 0), "counters not cleared"
+
+# No TE and no pacer : refresh() is not paced at all
+display.pacing(0)
+display.fake_te(0)
+assert display.pacing_stats()[4] == 0
+display.refresh()
+assert display.pacing_stats()[0] == 0
+display.deinit()
+
+# Double buffer : the present task waits for the edges
+display = amoled.AMOLED(amoled.MockPanel(width=240, height=536), type=0, bpp=16, double_buffer=True)
+display.fake_te(100)
+display.pacing_stats(True)
+t0 = time.ticks_us()
+for i in range(5):
+    display.swap()
+display.swap()                  # waits for the 5th present
+elapsed = time.ticks_diff(time.ticks_us(), t0)
+frames = display.pacing_stats()[0]
+assert frames >= 5, "%d frames presented" % frames
+assert elapsed >= 4 * 10000, "5 presents in %d us" % elapsed
+display.deinit()
+
+print("pacing OK")
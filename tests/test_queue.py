@@ -0,0 +1,47 @@
+"""
+Queued color transfers, on the unix port :
+
+    micropython tests/test_queue.py
+
+Each row of the frame has its own color, so a staging buffer refilled while its transfer is still
+in flight changes the checksum. Every queue depth must give the checksum of the blocking bus.
+"""
+
+import amoled
+
+W, H = 240, 536                 # type 0 (RM67162)
+
+
+def row_color(y):
+    return (y * 0x0107 + 0x2A) & 0xFFFF
+
+
+def area_sum(x, y, w, h):
+    # Bytes of the area refresh() sends, aligned like the driver does (even start, odd end)
+    sc, sr = x & ~1, y & ~1
+    ec, er = ((x + w - 1) & ~1) + 1, ((y + h - 1) & ~1) + 1
+    return sum((ec - sc + 1) * ((row_color(r) & 0xFF) + (row_color(r) >> 8)) for r in range(sr, er + 1))
+
+
+for depth in (0, 1, 2, 4, 8):
+    panel = amoled.MockPanel(width=W, height=H, queue_depth=depth)
+    display = amoled.AMOLED(panel, type=0, bpp=16, auto_refresh=amoled.AMOLED.REFRESH_OFF)
+    for y in range(H):
+        display.hline(0, y, W, row_color(y))
+
+    for area in ((0, 0, W, H), (13, 7, 50, 301)):
+        panel.wait()
+        panel.reset_stats()
+        display.refresh(*area)
+        panel.wait()
+        params, colors, color_bytes, transactions, queued, max_queued, stalls, checksum = panel.stats()
+        assert checksum == area_sum(*area), "depth %d area %s : checksum %d instead of %d" % (depth, area, checksum, area_sum(*area))
+        assert max_queued <= depth, "depth %d : %d transactions in flight" % (depth, max_queued)
+        if depth == 1:          # RAMWR header and data of a strip can't be in flight together
+            assert stalls > 0
+        else:                   # strips are smaller than a transaction, a transfer never fills the queue
+            assert stalls == 0, "depth %d : %d stalls" % (depth, stalls)
+
+    display.deinit()
+
+print("queue OK")
@@ -0,0 +1,105 @@
+"""
+Double buffer and present task, on the unix port (the task is a pthread) :
+
+    micropython tests/test_swap.py
+
+Drawings go to the back buffer, only swap() sends them to the GRAM.
+"""
+
+import time
+import amoled
+
+W, H = 240, 536                 # type 0 (RM67162)
+
+panel = amoled.MemPanel(width=W, height=H)
+display = amoled.AMOLED(panel, type=0, bpp=16, double_buffer=True)
+
+
+def bus(color):
+    return ((color & 0xFF) << 8) | (color >> 8)
+
+
+def presented():
+    # Wait for the present task to finish the frame handed by swap()
+    for i in range(1000):
+        if not display.present_stats()[2]:
+            return
+        time.sleep_ms(1)
+    raise AssertionError("present task never finished")
+
+
+# auto_refresh ON is turned into deferred
+assert display.auto_refresh() == amoled.AMOLED.REFRESH_DEFERRED
+try:
+    display.auto_refresh(amoled.AMOLED.REFRESH_ON)
+    raise AssertionError("auto_refresh ON accepted")
+except ValueError:
+    pass
+
+frames = display.present_stats()[0]
+
+# Deferred : the damaged areas are sent, and copied to the new back buffer
+display.fill(amoled.RED)
+presented()
+assert panel.pixel(0, 0) != bus(amoled.RED), "drawn without swap()"
+blocked = display.swap()
+assert isinstance(blocked, int) and blocked >= 0
+presented()
+assert display.present_stats()[0] == frames + 1
+assert panel.pixel(0, 0) == bus(amoled.RED)
+assert panel.pixel(W - 1, H - 1) == bus(amoled.RED)
+
+panel.reset_stats()
+display.fill_rect(20, 30, 8, 4, amoled.BLUE)
+display.swap()
+presented()
+assert panel.pixel(20, 30) == bus(amoled.BLUE)
+assert panel.pixel(19, 30) == bus(amoled.RED)
+assert panel.stats()[3] < W * H * 2, "deferred swap() sent the whole frame"
+
+# Each deferred swap() only sends what was drawn since the last one
+display.fill_rect(100, 100, 2, 2, amoled.GREEN)
+display.swap()
+presented()
+assert panel.pixel(100, 100) == bus(amoled.GREEN)
+assert panel.pixel(20, 30) == bus(amoled.BLUE)
+
+# Leaving deferred mode keeps the pending areas for the next swap(), nothing is sent before
+display.fill_rect(60, 60, 4, 4, amoled.WHITE)
+display.auto_refresh(amoled.AMOLED.REFRESH_OFF)
+presented()
+assert panel.pixel(60, 60) == bus(amoled.RED), "auto_refresh() sent the back buffer"
+
+# Not deferred : the whole frame is sent, copy=True keeps it in the new back buffer
+panel.reset_stats()
+display.swap(True)
+presented()
+assert panel.stats()[3] == W * H * 2
+assert panel.pixel(60, 60) == 0xFFFF
+assert panel.pixel(20, 30) == bus(amoled.BLUE), "back buffer missed an earlier frame"
+assert panel.pixel(100, 100) == bus(amoled.GREEN), "back buffer missed the last frame"
+display.fill_rect(0, 0, 2, 2, amoled.YELLOW)
+display.swap()
+presented()
+assert panel.pixel(0, 0) == bus(amoled.YELLOW)
+assert panel.pixel(60, 60) == 0xFFFF
+
+# flush() presents through swap() too
+display.auto_refresh(amoled.AMOLED.REFRESH_DEFERRED)
+display.fill_rect(200, 500, 2, 2, amoled.CYAN)
+display.flush()
+presented()
+assert panel.pixel(200, 500) == bus(amoled.CYAN)
+
+# Rotation waits for the task, the next deferred swap() sends the whole screen
+display.rotation(1)
+display.fill(amoled.MAGENTA)
+panel.reset_stats()
+display.swap()
+presented()
+assert panel.stats()[3] == W * H * 2
+assert panel.pixel(0, 0) == bus(amoled.MAGENTA)
+display.rotation(0)
+
+display.deinit()
+print("swap OK")
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+Replay a bus trace written by display.trace_dump() and report, frame by frame,
+the bytes and transactions sent to the panel and the redundant window writes.
+
+    display.trace(4096)             # on the board, start a trace of 4096 records
+    ...                             # run the UI, refresh() and flush() end frames
+    display.trace_dump("/ui.trc")
+
+    python3 amoled_trace.py ui.trc [--gap MS] [-v]
+
+--gap MS also ends a frame after MS milliseconds without bus activity (auto_refresh ON
+has no refresh() or flush() to mark frames). -v lists every record.
+"""
+
+import argparse
+import struct
+import sys
+
+TRACE_PARAM = 0
+TRACE_COLOR = 1
+TRACE_FRAME = 2
+TRACE_WINDOW_BIT = 0x80
+
+CMD_CASET = 0x2A
+CMD_RASET = 0x2B
+CMD_SWRESET = 0x01
+CMD_MADCTL = 0x36
+
+HEADER = struct.Struct("<4sBxBxII")
+RECORD = struct.Struct("<IIBBH8s")
+
+
+class Frame:
+    def __init__(self, number):
+        self.number = number
+        self.start = None
+        self.end = None
+        self.param_bytes = 0
+        self.color_bytes = 0
+        self.transactions = 0
+        self.windows = 0
+        self.redundant = 0
+        self.records = []
+
+    def add_time(self, time):
+        if self.start is None:
+            self.start = time
+        self.end = time
+
+    def duration(self):
+        if self.start is None:
+            return 0
+        return (self.end - self.start) & 0xFFFFFFFF
+
+
+def read_trace(filename):
+    with open(filename, "rb") as f:
+        data = f.read()
+    magic, version, rec_size, count, lost = HEADER.unpack_from(data, 0)
+    if magic != b"AMTR":
+        raise ValueError("not an amoled trace file")
+    if version != 1 or rec_size != RECORD.size:
+        raise ValueError("unsupported trace version %d (record size %d)" % (version, rec_size))
+    records = [RECORD.unpack_from(data, HEADER.size + i * rec_size) for i in range(count)]
+    return records, lost
+
+
+def window(data):
+    sc, ec, sr, er = struct.unpack(">HHHH", data)
+    return sc, sr, ec, er
+
+
+def replay(records, gap_us=None, verbose=False):
+    frames = []
+    frame = Frame(0)
+    caset = None        # panel registers as rebuilt from the trace
+    raset = None
+    last_time = None
+
+    for time, length, kind, cmd, _, data in records:
+        if gap_us is not None and last_time is not None and frame.transactions:
+            if ((time - last_time) & 0xFFFFFFFF) > gap_us:
+                frames.append(frame)
+                frame = Frame(len(frames))
+        last_time = time
+
+        if kind == TRACE_FRAME:
+            frame.add_time(time)
+            frames.append(frame)
+            frame = Frame(len(frames))
+            continue
+
+        frame.add_time(time)
+        if verbose:
+            frame.records.append((time, length, kind, cmd, data))
+
+        if (kind & ~TRACE_WINDOW_BIT) == TRACE_PARAM:
+            frame.param_bytes += length
+            if not kind & TRACE_WINDOW_BIT:
+                frame.transactions += 1
+            if cmd in (CMD_CASET, CMD_RASET):
+                frame.windows += 1
+                value = bytes(data[:4])
+                if cmd == CMD_CASET:
+                    frame.redundant += value == caset
+                    caset = value
+                else:
+                    frame.redundant += value == raset
+                    raset = value
+            elif cmd in (CMD_SWRESET, CMD_MADCTL):
+                caset = raset = None
+        elif kind == TRACE_COLOR:
+            frame.color_bytes += length
+            frame.transactions += 1
+
+    if frame.transactions:
+        frames.append(frame)
+    return frames
+
+
+def print_record(time, length, kind, cmd, data):
+    name = {TRACE_PARAM: "param", TRACE_COLOR: "color"}.get(kind & ~TRACE_WINDOW_BIT, "?")
+    extra = ""
+    if kind == TRACE_COLOR:
+        extra = "window=%d,%d-%d,%d" % window(data)
+    elif cmd in (CMD_CASET, CMD_RASET):
+        extra = "%d-%d" % struct.unpack(">HH", data[:4])
+    print("    %10d us  %-5s 0x%02X %8d B %s%s" % (
+        time, name, cmd, length, extra, " (tx_window)" if kind & TRACE_WINDOW_BIT else ""))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="amoled bus trace replay")
+    parser.add_argument("trace", help="file written by display.trace_dump()")
+    parser.add_argument("--gap", type=float, default=None, help="also end a frame after GAP ms without bus activity")
+    parser.add_argument("-v", "--verbose", action="store_true", help="list every record")
+    args = parser.parse_args()
+
+    records, lost = read_trace(args.trace)
+    frames = replay(records, None if args.gap is None else int(args.gap * 1000), args.verbose)
+
+    if lost:
+        print("%d oldest records were lost, first frame may be incomplete" % lost)
+    print("%6s %10s %10s %8s %8s %9s %10s" % ("frame", "bytes", "color", "trans", "windows", "redundant", "time us"))
+    total = Frame(-1)
+    for f in frames:
+        print("%6d %10d %10d %8d %8d %9d %10d" % (
+            f.number, f.param_bytes + f.color_bytes, f.color_bytes, f.transactions, f.windows, f.redundant, f.duration()))
+        for r in f.records:
+            print_record(*r)
+        total.param_bytes += f.param_bytes
+        total.color_bytes += f.color_bytes
+        total.transactions += f.transactions
+        total.windows += f.windows
+        total.redundant += f.redundant
+
+    if frames:
+        n = len(frames)
+        print("%6s %10d %10d %8d %8d %9d" % (
+            "total", total.param_bytes + total.color_bytes, total.color_bytes, total.transactions, total.windows, total.redundant))
+        print("%6s %10d %10d %8.1f %8.1f %9.1f" % (
+            "mean", (total.param_bytes + total.color_bytes) // n, total.color_bytes // n,
+            total.transactions / n, total.windows / n, total.redundant / n))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())